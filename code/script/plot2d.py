@@ -4,6 +4,8 @@ import matplotlib.pyplot as plt
 from matplotlib.collections import EllipseCollection
 import matplotlib.animation as animation
 
+from trajectory import Trajectory
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("filename", help="filename of the state file")
@@ -13,6 +15,12 @@ if __name__ == "__main__":
     args = parser.parse_args()
 
     def read_sample():
+        if args.filename.endswith(".traj"):
+            trajectory = Trajectory(args.filename)
+            for frame in trajectory.frames[args.start::args.step]:
+                yield trajectory.charges, frame[:, 0], frame[:, 1]
+            return
+
         samples = np.loadtxt(args.filename)[args.start::args.step,:]
 
         for sample in samples:
@@ -0,0 +1,53 @@
+"""Zero-copy access to binary trajectories written by TrajectoryWriter.
+
+The file is memory-mapped with numpy.memmap, so frames are numpy views of the
+mapping and are only read from disk when accessed.
+"""
+import os
+import struct
+
+import numpy as np
+
+HEADER_FORMAT = "=8sIIQIIdd"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+MAGIC = b"PIAPTRJ\0"
+
+
+class Trajectory:
+    """Binary trajectory, see code/src/Trajectory.h for the layout."""
+
+    def __init__(self, filename):
+        with open(filename, "rb") as f:
+            fields = struct.unpack(HEADER_FORMAT, f.read(HEADER_SIZE))
+        magic, version, dim, n_particles, precision, stride, box, beta = fields
+        file_size = os.path.getsize(filename)
+        # Bounding n_particles by the file size rejects corrupt headers
+        # before they enter the offsets
+        if (magic != MAGIC or version != 1 or precision not in (4, 8)
+                or not 1 <= dim <= 4 or n_particles == 0
+                or n_particles > (file_size - HEADER_SIZE) // 8):
+            raise ValueError("not a trajectory file: " + filename)
+
+        self.dim = dim
+        self.n_particles = n_particles
+        self.stride = stride
+        self.box_length = box
+        self.beta = beta
+
+        self.charges = np.memmap(filename, dtype=np.float64, mode="r",
+                                 offset=HEADER_SIZE, shape=(n_particles,))
+
+        dtype = np.float32 if precision == 4 else np.float64
+        offset = HEADER_SIZE + 8 * n_particles
+        frame_size = n_particles * dim
+        n_values = (file_size - offset) // precision
+        n_frames = n_values // frame_size
+        self.frames = np.memmap(filename, dtype=dtype, mode="r", offset=offset,
+                                shape=(n_frames, n_particles, dim))
+
+    def __len__(self):
+        return self.frames.shape[0]
+
+    def __getitem__(self, i):
+        """Coordinates of frame i as (n_particles, dim) view."""
+        return self.frames[i]
@@ -0,0 +1,119 @@
+#ifndef BINARYIO_H_
+#define BINARYIO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Helpers writing values in native byte order, used by the save() and load()
+ * members of the classes that can be checkpointed. The read functions return
+ * false if the stream ran out of data.
+ */
+template <typename T>
+void write_binary(std::ostream &os, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable types can be written");
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_binary(std::istream &is, T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable types can be read");
+    is.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return static_cast<bool>(is);
+}
+
+/**
+ * Whether the stream holds at least n more elements of the given size. The
+ * sizes of vectors and strings come from the file, checking them first
+ * turns a corrupt size into a failed read instead of a huge allocation.
+ * Streams that cannot seek are trusted up to max_unchecked_bytes.
+ */
+inline bool stream_holds(std::istream &is, std::uint64_t n,
+                         std::size_t element_size) {
+    const std::uint64_t max_unchecked_bytes = std::uint64_t(1) << 30;
+    const auto pos = is.tellg();
+    if (pos == std::istream::pos_type(-1)) {
+        is.clear(is.rdstate() & ~std::ios::failbit);
+        return n <= max_unchecked_bytes / element_size;
+    }
+    is.seekg(0, std::ios::end);
+    const auto end = is.tellg();
+    is.seekg(pos);
+    if (end == std::istream::pos_type(-1) || !is) {
+        return false;
+    }
+    return n <= static_cast<std::uint64_t>(end - pos) / element_size;
+}
+
+/**
+ * Vectors are stored as their size followed by the elements.
+ */
+template <typename T, typename Allocator>
+void write_binary(std::ostream &os, const std::vector<T, Allocator> &values) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable types can be written");
+    write_binary(os, static_cast<std::uint64_t>(values.size()));
+    os.write(reinterpret_cast<const char *>(values.data()),
+             values.size() * sizeof(T));
+}
+
+template <typename T, typename Allocator>
+bool read_binary(std::istream &is, std::vector<T, Allocator> &values) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable types can be read");
+    std::uint64_t size = 0;
+    if (!read_binary(is, size) || !stream_holds(is, size, sizeof(T))) {
+        return false;
+    }
+    values.resize(size);
+    is.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+    return static_cast<bool>(is);
+}
+
+inline void write_binary(std::ostream &os, const std::string &value) {
+    write_binary(os, static_cast<std::uint64_t>(value.size()));
+    os.write(value.data(), value.size());
+}
+
+inline bool read_binary(std::istream &is, std::string &value) {
+    std::uint64_t size = 0;
+    if (!read_binary(is, size) || !stream_holds(is, size, 1)) {
+        return false;
+    }
+    value.resize(size);
+    is.read(&value[0], size);
+    return static_cast<bool>(is);
+}
+
+/**
+ * Random number engines are stored in their textual representation, which
+ * the standard engines provide through operator<< and operator>>.
+ */
+template <typename Rng>
+void write_engine(std::ostream &os, const Rng &rng) {
+    std::ostringstream ss;
+    ss << rng;
+    write_binary(os, ss.str());
+}
+
+template <typename Rng>
+bool read_engine(std::istream &is, Rng &rng) {
+    std::string text;
+    if (!read_binary(is, text)) {
+        return false;
+    }
+    std::istringstream ss(text);
+    ss >> rng;
+    return static_cast<bool>(ss);
+}
+
+#endif // BINARYIO_H_
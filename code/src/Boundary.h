@@ -0,0 +1,36 @@
+#ifndef BOUNDARY_H_
+#define BOUNDARY_H_
+
+#include <cmath>
+
+/**
+ * Treatment of the walls of the simulation box [-L/2, L/2]^dim.
+ *     hard:       proposals leaving the box are redrawn
+ *     periodic:   the box is repeated periodically, distances follow the
+ *                 minimum image convention
+ *     reflecting: proposals leaving the box are mirrored at the wall
+ */
+enum class Boundary { hard, periodic, reflecting };
+
+/**
+ * Maps a coordinate (or a coordinate difference) to its periodic image in
+ * [-L/2, L/2]. inv_box_length = 0 disables the wrapping, which lets callers
+ * handle open and periodic boxes without branching.
+ */
+inline double minimum_image(double x, double box_length,
+                            double inv_box_length) {
+    return x - box_length * std::nearbyint(x * inv_box_length);
+}
+
+/**
+ * Mirrors a coordinate at the walls at -limit and limit until it lies in
+ * [-limit, limit], i.e. folds it with period 4 * limit.
+ */
+inline double reflect(double x, double limit) {
+    const auto period = 4.0 * limit;
+    const auto y = x + limit;
+    const auto m = y - period * std::floor(y / period);
+    return 2.0 * limit - std::fabs(2.0 * limit - m) - limit;
+}
+
+#endif // BOUNDARY_H_
@@ -1,19 +1,132 @@
 #ifndef CANONICALENSEMBLE_H_
 #define CANONICALENSEMBLE_H_
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <functional>
+#include <future>
+#include <istream>
+#include <numeric>
+#include <ostream>
 #include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "BinaryIO.h"
+#include "Boundary.h"
+#include "CellList.h"
+#include "Checkerboard.h"
+#include "Random.h"
+#include "SoAState.h"
+#include "ThreadPool.h"
+#include "VerletList.h"
+
+/**
+ * Detects whether a potential provides a vectorized energy row
+ *     double row(const SoAState<dim> &, const ParticleState &p,
+ *                std::size_t ix, double *out) const
+ * evaluating the interaction of particle ix located at p with all others.
+ */
+template <typename Potential, typename ParticleState, typename = void>
+struct HasRowKernel : std::false_type {};
+
+template <typename Potential, typename ParticleState>
+struct HasRowKernel<
+    Potential, ParticleState,
+    decltype(void(std::declval<const Potential &>().row(
+        std::declval<const SoAState<ParticleTraits<ParticleState>::dim> &>(),
+        std::declval<const ParticleState &>(), std::size_t(),
+        static_cast<double *>(nullptr))))> : std::true_type {};
+
+/**
+ * Detects whether a potential provides a lower bound of the pair energy over
+ * all distances
+ *     double min_pair_energy(const ParticleState &a,
+ *                            const ParticleState &b) const,
+ * which allows a step to be rejected before its energy row is complete.
+ */
+template <typename Potential, typename ParticleState, typename = void>
+struct HasPairFloor : std::false_type {};
+
+template <typename Potential, typename ParticleState>
+struct HasPairFloor<
+    Potential, ParticleState,
+    decltype(void(std::declval<const Potential &>().min_pair_energy(
+        std::declval<const ParticleState &>(),
+        std::declval<const ParticleState &>())))> : std::true_type {};
+
+/**
+ * Detects whether a potential provides the force between two particles
+ *     std::array<double, dim> force(const ParticleState &a,
+ *                                   const ParticleState &b) const,
+ * exerted by b on a, which CanonicalEnsemble::forces() needs.
+ */
+template <typename Potential, typename ParticleState, typename = void>
+struct HasForce : std::false_type {};
+
+template <typename Potential, typename ParticleState>
+struct HasForce<Potential, ParticleState,
+                decltype(void(std::declval<const Potential &>().force(
+                    std::declval<const ParticleState &>(),
+                    std::declval<const ParticleState &>())))>
+    : std::true_type {};
+
+/**
+ * Detects whether a potential has a long-range part that is not a sum of
+ * pair energies, e.g. the reciprocal sum of EwaldCoulombCore. Such potentials
+ * provide
+ *     void long_range_reset(const std::vector<ParticleState> &),
+ *     double long_range_trial(const ParticleState &old_pos,
+ *                             const ParticleState &new_pos),
+ *     void long_range_accept(),
+ *     double long_range_energy() const,
+ * where trial returns the energy change of a single particle move and accept
+ * commits the last trial.
+ */
+template <typename Potential, typename = void>
+struct HasLongRange : std::false_type {};
+
+template <typename Potential>
+struct HasLongRange<Potential,
+                    decltype(void(std::declval<const Potential &>()
+                                      .long_range_energy()))>
+    : std::true_type {};
+
 /**
  * CanonicalEnsemble
  *
  * Simulates a canonical ensemble at a specified temperature and potential using
  * a Random-Walk Metropolis-Algorithm using a single particle update with a
  * specified proposal distribution.
+ *
+ * The potential and the proposal are policies resolved at compile time, so
+ * that the pair potential can be inlined into the energy loop. They default to
+ * std::function, which accepts any callable at the cost of an indirect call.
+ * Potentials providing a row kernel (see HasRowKernel) are evaluated on a
+ * structure-of-arrays copy of the state, one particle against all at once.
+ * Potentials providing a lower bound of the pair energy (see HasPairFloor)
+ * allow the cached step to stop summing an energy row once rejection is
+ * certain. The long-range part of potentials like EwaldCoulombCore (see
+ * HasLongRange) is updated with every accepted move as well.
+ * With the cell list, optional Verlet lists restrict the energy rows to the
+ * neighbours of the moved particle.
+ * Short-range potentials can alternatively be sampled by checkerboard
+ * sweeps, which move the particles of non-interacting domains of the box
+ * concurrently. Potentials providing forces (see HasForce) support
+ * collective moves of all particles like HybridMonteCarlo.
+ * The random number generator is a policy as well, the proposal has to accept
+ * it (e.g. XoshiroBatch together with a templated proposal).
  */
-template <typename ParticleState>
+template <typename ParticleState,
+          typename Potential = std::function<double(const ParticleState &,
+                                                    const ParticleState &)>,
+          typename Proposal = std::function<ParticleState(
+              const ParticleState &, std::mt19937 &)>,
+          typename Rng = std::mt19937>
 class CanonicalEnsemble {
 public:
     /**
@@ -24,80 +137,924 @@ public:
     /**
      * Type specifying the interparticle potential.
      */
-    using PotentialFunction =
-        std::function<double(const ParticleState &, const ParticleState &)>;
+    using PotentialFunction = Potential;
 
     /**
      * Type of a function proposing a new state for a single particle from the
      * current state.
      */
-    using ProposalFunction =
-        std::function<ParticleState(const ParticleState &, std::mt19937 &)>;
+    using ProposalFunction = Proposal;
+
+    /**
+     * Type of a function notified after every accepted move with the new
+     * state, the index of the moved particle and its previous state.
+     */
+    using MoveObserver = std::function<void(
+        const State &, typename State::size_type, const ParticleState &)>;
+
+    /**
+     * Force on a particle, minus the gradient of the potential energy with
+     * respect to its coordinates.
+     */
+    using Force = std::array<double, ParticleTraits<ParticleState>::dim>;
 
 public:
     /**
      * Constructor taking the initial state of the simulation, thermodynamic
-     * beta, interparticle potential and proposal function.
+     * beta, interparticle potential and proposal function. The random number
+     * generator is seeded non-reproducibly.
      */
     CanonicalEnsemble(const State &initial_state, double beta,
                       PotentialFunction potential_func,
                       ProposalFunction proposal_func)
-        : rng(std::random_device{}()), unif_index(0, initial_state.size() - 1),
+        : CanonicalEnsemble(initial_state, beta, potential_func,
+                            proposal_func, random_seed()) {}
+
+    /**
+     * Constructor additionally taking the seed of the random number
+     * generator. Ensembles constructed from equal arguments produce equal
+     * chains.
+     */
+    CanonicalEnsemble(const State &initial_state, double beta,
+                      PotentialFunction potential_func,
+                      ProposalFunction proposal_func, const Seed &seed)
+        : rng(make_rng<Rng>(seed)), unif_index(0, initial_state.size() - 1),
           potential_func(potential_func), proposal_func(proposal_func),
-          state(initial_state), beta(beta) {}
+          state(initial_state), beta(beta) {
+        if (HasRowKernel<Potential, ParticleState>::value) {
+            soa = SoAState<dim>(state);
+            row_buffer.resize(soa.padded_size());
+            old_row_buffer.resize(soa.padded_size());
+        }
+        pair_floor = min_pair_energy(HasPairFloor<Potential, ParticleState>());
+        reset_long_range(HasLongRange<Potential>());
+    }
 
     /**
      * Returns a reference to the current state of the simulation.
      */
     const State &get_state() const { return state; }
 
+    /**
+     * Registers a function notified after every accepted move, which allows
+     * observables to be maintained incrementally. Observers are not notified
+     * by swap_configuration().
+     */
+    void add_move_observer(MoveObserver observer) {
+        observers.push_back(std::move(observer));
+    }
+
+    /**
+     * Returns the thermodynamic beta.
+     */
+    double get_beta() const { return beta; }
+
+    /**
+     * Returns the proposal, e.g. to adjust its step size during burn-in.
+     */
+    ProposalFunction &get_proposal() { return proposal_func; }
+
+    const ProposalFunction &get_proposal() const { return proposal_func; }
+
+    /**
+     * Exchanges the configuration (state, cached energies and spatial
+     * indices) with another ensemble, while beta, proposal and random number
+     * generator stay. Both ensembles have to use the same energy cache, cell
+     * list and Verlet list settings. Used for replica exchange.
+     */
+    void swap_configuration(CanonicalEnsemble &other) {
+        using std::swap;
+        swap(state, other.state);
+        swap(energies, other.energies);
+        swap(total_energy, other.total_energy);
+        swap(pair_floor, other.pair_floor);
+        swap(cells, other.cells);
+        swap(neighbours, other.neighbours);
+        swap(soa, other.soa);
+        swap_long_range(other, HasLongRange<Potential>());
+    }
+
+    /**
+     * Writes the configuration, beta, the state of the random number
+     * generator and the cached energies for a checkpoint. Potential,
+     * proposal, observers and the settings of cache and cell list are part
+     * of the construction of the ensemble that loads the checkpoint.
+     */
+    void save(std::ostream &os) const {
+        using Traits = ParticleTraits<ParticleState>;
+        write_binary(os, static_cast<std::uint64_t>(state.size()));
+        for (const auto &p : state) {
+            write_binary(os, static_cast<double>(p.q));
+            for (size_type d = 0; d < dim; ++d) {
+                write_binary(os, Traits::coordinate(p, d));
+            }
+        }
+        write_binary(os, beta);
+        write_engine(os, rng);
+        write_binary(os, energies);
+        write_binary(os, total_energy);
+        write_binary(os, static_cast<std::uint64_t>(domain_rngs.size()));
+        for (const auto &domain_rng : domain_rngs) {
+            write_engine(os, domain_rng);
+        }
+    }
+
+    /**
+     * Restores a checkpoint written by save() of an ensemble constructed
+     * with the same number of particles. The cached energies are taken over
+     * as they are, so that an ensemble with enabled energy cache continues
+     * the same chain. Spatial indices and the long-range part of the
+     * potential are rebuilt.
+     * returns: false if the stream does not hold a matching checkpoint
+     */
+    bool load(std::istream &is) {
+        using Traits = ParticleTraits<ParticleState>;
+        std::uint64_t size = 0;
+        if (!read_binary(is, size) || size != state.size()) {
+            return false;
+        }
+        State loaded;
+        loaded.reserve(state.size());
+        for (size_type i = 0; i < state.size(); ++i) {
+            double q = 0.0;
+            double x[dim];
+            if (!read_binary(is, q)) {
+                return false;
+            }
+            for (size_type d = 0; d < dim; ++d) {
+                if (!read_binary(is, x[d])) {
+                    return false;
+                }
+            }
+            loaded.push_back(Traits::make(q, x));
+        }
+        std::vector<double> loaded_energies;
+        auto loaded_total = 0.0;
+        auto loaded_beta = 0.0;
+        auto loaded_rng = rng;
+        if (!read_binary(is, loaded_beta) || !read_engine(is, loaded_rng) ||
+            !read_binary(is, loaded_energies) ||
+            !read_binary(is, loaded_total) ||
+            (energy_cache && loaded_energies.size() != state.size())) {
+            return false;
+        }
+        std::uint64_t domain_num = 0;
+        if (!read_binary(is, domain_num) || domain_num != domain_rngs.size()) {
+            return false;
+        }
+        auto loaded_domain_rngs = domain_rngs;
+        for (auto &domain_rng : loaded_domain_rngs) {
+            if (!read_engine(is, domain_rng)) {
+                return false;
+            }
+        }
+
+        for (size_type i = 0; i < state.size(); ++i) {
+            move(i, loaded[i]);
+        }
+        beta = loaded_beta;
+        rng = loaded_rng;
+        domain_rngs = loaded_domain_rngs;
+        pair_floor = min_pair_energy(HasPairFloor<Potential, ParticleState>());
+        reset_long_range(HasLongRange<Potential>());
+        if (energy_cache) {
+            energies = loaded_energies;
+            total_energy = loaded_total;
+        }
+        return true;
+    }
+
+    /**
+     * Enables the per-particle energy cache. The potential energy of every
+     * particle is kept up to date, so that a step only has to evaluate the
+     * interaction row of the proposed position. Calling this again recomputes
+     * the cache from scratch, which discards accumulated round-off.
+     */
+    void enable_energy_cache() {
+        energies.resize(state.size());
+        for (size_type i = 0; i < state.size(); ++i) {
+            energies[i] = potential(state[i], i);
+        }
+        reset_long_range(HasLongRange<Potential>());
+        total_energy =
+            0.5 * std::accumulate(energies.cbegin(), energies.cend(), 0.0) +
+            long_range_energy(HasLongRange<Potential>());
+        energy_cache = true;
+    }
+
+    /**
+     * Enables the cell list for short-range potentials in a box of the given
+     * side length. Pairs further apart than the cutoff no longer interact,
+     * and the energy of a move is only summed over the adjacent cells.
+     * Re-enables an active energy cache so that it uses the truncated
+     * potential. In a periodic box the cutoff applies to the minimum image
+     * distance and must not exceed half the side length; the potential has to
+     * use periodic boundaries as well.
+     */
+    void enable_cell_list(double box_length, double cutoff,
+                          Boundary boundary = Boundary::hard) {
+        const auto periodic = boundary == Boundary::periodic;
+        cells = CellList<ParticleState>(box_length, cutoff, state, periodic);
+        cell_list = true;
+        cell_box_length = box_length;
+        cutoff_sq = cutoff * cutoff;
+        periodic_length = periodic ? box_length : 0.0;
+        if (neighbour_list) {
+            enable_neighbour_list(neighbours.get_skin());
+        }
+        if (energy_cache) {
+            enable_energy_cache();
+        }
+    }
+
+    /**
+     * Enables Verlet lists of the neighbours within cutoff + skin of every
+     * particle, which replace the adjacent cells in the energy rows. The
+     * lists are rebuilt before a step once an accepted move has taken a
+     * particle further than skin / 2 from its position at the last build,
+     * so for step sizes well below the skin the rows cost O(neighbours)
+     * with rare rebuilds. Requires the cell list, which supplies box and
+     * cutoff; throws std::logic_error without it.
+     */
+    void enable_neighbour_list(double skin) {
+        if (!cell_list) {
+            throw std::logic_error(
+                "enable_neighbour_list() requires enable_cell_list()");
+        }
+        neighbours = VerletList<ParticleState>(
+            cell_box_length, std::sqrt(cutoff_sq), skin, periodic_length > 0.0);
+        neighbours.build(state);
+        neighbour_list = true;
+    }
+
+    /**
+     * Returns the Verlet lists, e.g. to count their builds.
+     */
+    const VerletList<ParticleState> &get_neighbour_list() const {
+        return neighbours;
+    }
+
+    /**
+     * Enables checkerboard_sweep() for potentials without long-range part.
+     * Requires the cell list, whose cutoff bounds the domains from below,
+     * and throws std::logic_error without it. Enables the energy cache if
+     * it is not active yet. Every domain draws from its own random number
+     * stream, seeded from the generator of the ensemble, so that a seeded
+     * ensemble gives the same chain for any number of threads.
+     */
+    void enable_checkerboard() {
+        if (!cell_list) {
+            throw std::logic_error(
+                "enable_checkerboard() requires enable_cell_list()");
+        }
+        if (!energy_cache) {
+            enable_energy_cache();
+        }
+        board = Checkerboard<ParticleState>(
+            cell_box_length, std::sqrt(cutoff_sq), periodic_length > 0.0);
+        std::uniform_int_distribution<std::uint64_t> unif_seed;
+        const auto master = unif_seed(rng);
+        domain_rngs.clear();
+        for (size_type c = 0; c < board.domain_count(); ++c) {
+            domain_rngs.push_back(make_rng<Rng>(Seed{master, c}));
+        }
+        domain_updates.assign(board.domain_count(), DomainUpdate());
+        moved_flags.assign(state.size(), 0);
+    }
+
+    /**
+     * Computes the forces on the particles of configuration s into forces
+     * and returns its potential energy. Like the energies, the forces are
+     * truncated at the cutoff of the cell list, if enabled. Requires a
+     * potential providing forces (see HasForce) without long-range part.
+     */
+    double forces(const State &s, std::vector<Force> &forces) const {
+        static_assert(HasForce<Potential, ParticleState>::value,
+                      "the potential provides no forces");
+        static_assert(!HasLongRange<Potential>::value,
+                      "the long-range part has no forces");
+
+        forces.assign(s.size(), Force());
+        auto ret = 0.0;
+        auto add_pair = [&](size_type i, size_type j) {
+            const auto f = potential_func.force(s[i], s[j]);
+            for (size_type d = 0; d < dim; ++d) {
+                forces[i][d] += f[d];
+                forces[j][d] -= f[d];
+            }
+            ret += potential_func(s[i], s[j]);
+        };
+
+        if (!cell_list) {
+            for (size_type i = 0; i < s.size(); ++i) {
+                for (size_type j = i + 1; j < s.size(); ++j) {
+                    add_pair(i, j);
+                }
+            }
+            return ret;
+        }
+        const CellList<ParticleState> s_cells(
+            cell_box_length, std::sqrt(cutoff_sq), s, periodic_length > 0.0);
+        for (size_type i = 0; i < s.size(); ++i) {
+            s_cells.for_each_neighbour(s[i], [&](size_type j) {
+                if (j > i && cell_distance_sq(s[i], s[j]) < cutoff_sq) {
+                    add_pair(i, j);
+                }
+            });
+        }
+        return ret;
+    }
+
+    /**
+     * Replaces the configuration by s after a collective move. Observers are
+     * notified of the moves one particle at a time, the energy cache is
+     * recomputed.
+     */
+    void set_configuration(const State &s) {
+        for (size_type i = 0; i < state.size(); ++i) {
+            const auto old = state[i];
+            move(i, s[i]);
+            notify(i, old);
+        }
+        if (energy_cache) {
+            enable_energy_cache();
+        } else {
+            reset_long_range(HasLongRange<Potential>());
+        }
+    }
+
+    /**
+     * Returns the cached potential energies of the individual particles. Only
+     * valid if the energy cache is enabled. A long-range part of the
+     * potential is not included.
+     */
+    const std::vector<double> &get_energies() const { return energies; }
+
+    /**
+     * Returns the total potential energy of the system. This is free if the
+     * energy cache is enabled and requires a pass over all pairs otherwise.
+     */
+    double energy() const {
+        if (energy_cache) {
+            return total_energy;
+        }
+        auto ret = 0.0;
+        for (size_type i = 0; i < state.size(); ++i) {
+            ret += potential(state[i], i);
+        }
+        return 0.5 * ret + long_range_energy(HasLongRange<Potential>());
+    }
+
     /**
      * Executes a single step of the Random-Walk Metropolis-Algorithm
      *
      * returns: bool - indicating whether the step was accepted.
      */
     bool step() {
+        if (neighbour_list && neighbours.is_stale()) {
+            neighbours.build(state);
+        }
+        if (energy_cache) {
+            return cached_step();
+        }
+
         // 1. Choose particle at random and calculate its potential
         const auto idx = unif_index(rng);
-        const auto current_pot = potential(idx);
+        const auto current = state[idx];
+        const auto current_pot = potential(current, idx);
 
         // 2. Propose a new state for the chosen particle and calculate the new
         //    potential
-        const auto current = state[idx];
-        state[idx] = proposal_func(current, rng);
-        const auto proposed_pot = potential(idx);
+        const auto proposed = proposal_func(current, rng);
+        const auto proposed_pot = potential(proposed, idx);
+        const auto long_range_delta = long_range_trial(
+            current, proposed, HasLongRange<Potential>());
 
         // 3. Accept-reject step
-        const auto accept_prob = std::exp(-beta * (proposed_pot - current_pot));
+        const auto accept_prob = std::exp(
+            -beta * (proposed_pot - current_pot + long_range_delta));
 
         const auto accepted = unif_real(rng) < accept_prob;
-        if (!accepted) {
-            // Revert proposal
-            state[idx] = current;
+        if (accepted) {
+            long_range_accept(HasLongRange<Potential>());
+            move(idx, proposed);
+            notify(idx, current);
+        }
+        return accepted;
+    }
+
+    /**
+     * Executes a sweep of as many single particle steps as there are
+     * particles, distributed over the checkerboard domains (see
+     * enable_checkerboard). The domain grid is shifted randomly, then the
+     * colours are updated one after the other in random order. The domains
+     * of a colour are updated concurrently on the pool, each one with as
+     * many steps as it holds particles; moves leaving their domain are
+     * rejected. Each colour update satisfies detailed balance on its own, so
+     * the sweep leaves the canonical distribution invariant. Observers are
+     * notified of the net move of every particle after each colour.
+     *
+     * returns: number of accepted steps
+     */
+    std::size_t checkerboard_sweep(ThreadPool &pool) {
+        static_assert(!HasLongRange<Potential>::value,
+                      "the long-range part couples all particles");
+
+        std::array<double, dim> offset;
+        for (auto &x : offset) {
+            x = unif_real(rng) * board.get_width();
+        }
+        board.assign(state, offset);
+
+        std::array<size_type, Checkerboard<ParticleState>::colour_count>
+            colours;
+        std::iota(colours.begin(), colours.end(), 0);
+        std::shuffle(colours.begin(), colours.end(), rng);
+
+        std::size_t accepted = 0;
+        for (const auto colour : colours) {
+            const auto &domains = board.domains(colour);
+            // A few tasks per thread balance unevenly occupied domains
+            const auto n_tasks = std::min(domains.size(), 4 * pool.size());
+            std::vector<std::future<void>> futures;
+            for (size_type t = 0; t < n_tasks; ++t) {
+                const auto first = domains.size() * t / n_tasks;
+                const auto last = domains.size() * (t + 1) / n_tasks;
+                futures.push_back(pool.submit([this, &domains, first, last] {
+                    auto proposal = proposal_func;
+                    for (auto k = first; k < last; ++k) {
+                        update_domain(domains[k], proposal);
+                    }
+                }));
+            }
+            for (auto &future : futures) {
+                future.get();
+            }
+            accepted += finish_colour(domains);
         }
         return accepted;
     }
 
 private:
+    using size_type = typename State::size_type;
+
     /**
-     * Calculates the potential of the specified particle
+     * Changes made by the update of a checkerboard domain that reach beyond
+     * it, applied after all domains of its colour are done.
      */
-    double potential(typename State::size_type ix) const {
-        const auto p = state.cbegin() + ix;
-        auto potential_energy = 0.0;
+    struct DomainUpdate {
+        std::size_t accepted = 0;
+        double energy_change = 0.0;
+        // Energy changes of particles outside the domain
+        std::vector<std::pair<size_type, double>> partner_changes;
+        // Moved particles and their positions before the update
+        std::vector<std::pair<size_type, ParticleState>> moved;
+        // Energy row of the proposed position
+        std::vector<std::pair<size_type, double>> row;
+    };
+
+    static constexpr std::size_t dim = ParticleTraits<ParticleState>::dim;
+
+    /**
+     * Metropolis step using the per-particle energy cache. Only the row of the
+     * proposed position is evaluated up front; the row of the old position is
+     * needed to patch the other particles' energies and is therefore only
+     * evaluated if the move is accepted.
+     */
+    bool cached_step() {
+        const auto idx = unif_index(rng);
+        const auto current = state[idx];
+        const auto proposed = proposal_func(current, rng);
+        const auto current_pot = energies[idx];
+        const auto long_range_delta = long_range_trial(
+            current, proposed, HasLongRange<Potential>());
+
+        // The move is accepted iff the proposed energy stays below a threshold
+        // drawn up front, which is equivalent to u < exp(-beta * dE)
+        const auto max_pot = current_pot - long_range_delta -
+                             std::log(unif_real(rng)) / beta;
+
+        auto proposed_pot = 0.0;
+        if (dense()) {
+            proposed_pot = dense_row(proposed, idx, row_buffer.data());
+        } else if (!partner_row(proposed, idx, max_pot, proposed_pot)) {
+            return false;
+        }
 
-        for (auto it = state.cbegin(), end = state.cend(); it != end; ++it) {
-            if (it != p) {
-                potential_energy += potential_func(*it, *p);
+        const auto accepted = proposed_pot < max_pot;
+        if (accepted) {
+            if (dense()) {
+                // Masked entries of both rows are zero
+                dense_row(current, idx, old_row_buffer.data());
+                for (size_type j = 0; j < state.size(); ++j) {
+                    energies[j] += row_buffer[j] - old_row_buffer[j];
+                }
+            } else {
+                for_each_partner(current, idx, [&](size_type j) {
+                    energies[j] -= potential_func(state[j], current);
+                });
+                for (const auto &entry : row) {
+                    energies[entry.first] += entry.second;
+                }
+            }
+            energies[idx] = proposed_pot;
+            total_energy += proposed_pot - current_pot + long_range_delta;
+            long_range_accept(HasLongRange<Potential>());
+            move(idx, proposed);
+            notify(idx, current);
+        }
+        return accepted;
+    }
+
+    /**
+     * Sums the energy row of particle ix located at p over its partners into
+     * row and pot. If the potential bounds the pair energy from below, the
+     * sum is aborted as soon as it would exceed max_pot even if all partners
+     * not visited yet contributed the bound. The cell list limits the number
+     * of those partners and visits the own cell first, whose overlapping
+     * neighbours dominate the sum.
+     * returns: false if the sum was aborted
+     */
+    bool partner_row(const ParticleState &p, size_type ix, double max_pot,
+                     double &pot) {
+        row.clear();
+        pot = 0.0;
+        if (!HasPairFloor<Potential, ParticleState>::value) {
+            for_each_partner(p, ix, [&](size_type j) {
+                const auto pair_pot = potential_func(state[j], p);
+                row.emplace_back(j, pair_pot);
+                pot += pair_pot;
+            });
+            return true;
+        }
+
+        // Partners not visited yet, an upper bound as it includes ix itself
+        // and particles beyond the cutoff
+        auto remaining = static_cast<double>(
+            listed(p, ix) ? neighbours.size(ix)
+            : cell_list   ? cells.neighbour_count(p)
+                          : state.size() - 1);
+        return for_each_partner_while(p, ix, [&](size_type j) {
+            const auto pair_pot = potential_func(state[j], p);
+            row.emplace_back(j, pair_pot);
+            pot += pair_pot;
+            remaining -= 1.0;
+            return pot + pair_floor * remaining < max_pot;
+        });
+    }
+
+    /**
+     * Performs the steps of checkerboard domain c. Only the particles of
+     * the domain move, so the energies of other particles and the cell list
+     * are left to finish_colour().
+     */
+    void update_domain(size_type c, ProposalFunction &proposal) {
+        const auto n = board.size(c);
+        if (n == 0) {
+            return;
+        }
+        const auto members = board.begin(c);
+        auto &domain_rng = domain_rngs[c];
+        auto &update = domain_updates[c];
+        std::uniform_int_distribution<size_type> unif_member(0, n - 1);
+        std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+        for (size_type k = 0; k < n; ++k) {
+            const auto idx = members[unif_member(domain_rng)];
+            const auto current = state[idx];
+            const auto proposed = proposal(current, domain_rng);
+            if (!board.contains(c, proposed)) {
+                continue;
+            }
+            const auto current_pot = energies[idx];
+            const auto max_pot =
+                current_pot - std::log(unif(domain_rng)) / beta;
+
+            auto proposed_pot = 0.0;
+            if (!domain_row(c, proposed, idx, max_pot, update.row,
+                            proposed_pot) ||
+                !(proposed_pot < max_pot)) {
+                continue;
+            }
+
+            for_each_domain_partner_while(c, current, idx, [&](size_type j) {
+                const auto pair_pot = potential_func(state[j], current);
+                if (board.domain_of(j) == c) {
+                    energies[j] -= pair_pot;
+                } else {
+                    update.partner_changes.emplace_back(j, -pair_pot);
+                }
+                return true;
+            });
+            for (const auto &entry : update.row) {
+                if (board.domain_of(entry.first) == c) {
+                    energies[entry.first] += entry.second;
+                } else {
+                    update.partner_changes.push_back(entry);
+                }
+            }
+            energies[idx] = proposed_pot;
+            update.energy_change += proposed_pot - current_pot;
+            ++update.accepted;
+
+            if (!moved_flags[idx]) {
+                moved_flags[idx] = 1;
+                update.moved.emplace_back(idx, current);
+            }
+            state[idx] = proposed;
+            if (HasRowKernel<Potential, ParticleState>::value) {
+                soa.set(idx, proposed);
+            }
+        }
+    }
+
+    /**
+     * Sums the energy row of particle ix of domain c located at p, see
+     * partner_row().
+     * returns: false if the sum was aborted
+     */
+    bool domain_row(size_type c, const ParticleState &p, size_type ix,
+                    double max_pot,
+                    std::vector<std::pair<size_type, double>> &row,
+                    double &pot) const {
+        row.clear();
+        pot = 0.0;
+        const auto floor = HasPairFloor<Potential, ParticleState>::value;
+        auto remaining =
+            floor ? static_cast<double>(board.size(c) +
+                                        cells.neighbour_count(p))
+                  : 0.0;
+        return for_each_domain_partner_while(c, p, ix, [&](size_type j) {
+            const auto pair_pot = potential_func(state[j], p);
+            row.emplace_back(j, pair_pot);
+            pot += pair_pot;
+            remaining -= 1.0;
+            return !floor || pot + pair_floor * remaining < max_pot;
+        });
+    }
+
+    /**
+     * Like for_each_partner_while for particle ix of domain c located at p
+     * during the update of its colour. The other particles of the domain
+     * are visited at their current positions, those of the other domains of
+     * the colour are skipped: they are out of reach and may be moving.
+     */
+    template <typename Function>
+    bool for_each_domain_partner_while(size_type c, const ParticleState &p,
+                                       size_type ix, Function f) const {
+        for (auto it = board.begin(c), end = board.end(c); it != end; ++it) {
+            const auto j = *it;
+            if (j != ix && cell_distance_sq(state[j], p) < cutoff_sq &&
+                !f(j)) {
+                return false;
+            }
+        }
+        const auto colour = board.colour_of(c);
+        return cells.for_each_neighbour_while(p, [&](size_type j) {
+            return board.colour_of(board.domain_of(j)) == colour ||
+                   cell_distance_sq(state[j], p) >= cutoff_sq || f(j);
+        });
+    }
+
+    /**
+     * Applies the changes of the domains of a colour beyond their own
+     * particles and notifies the observers of the net moves.
+     * returns: number of accepted steps of the domains
+     */
+    std::size_t finish_colour(const std::vector<size_type> &domains) {
+        std::size_t accepted = 0;
+        for (const auto c : domains) {
+            auto &update = domain_updates[c];
+            for (const auto &change : update.partner_changes) {
+                energies[change.first] += change.second;
+            }
+            total_energy += update.energy_change;
+            accepted += update.accepted;
+            for (const auto &entry : update.moved) {
+                cells.move(entry.first, state[entry.first]);
+                if (neighbour_list) {
+                    neighbours.move(entry.first, state[entry.first]);
+                }
+                moved_flags[entry.first] = 0;
+            }
+        }
+
+        // Replays the net moves one at a time, starting from the state
+        // before the colour update
+        if (!observers.empty()) {
+            for (const auto c : domains) {
+                for (auto &entry : domain_updates[c].moved) {
+                    std::swap(state[entry.first], entry.second);
+                }
+            }
+            for (const auto c : domains) {
+                for (auto &entry : domain_updates[c].moved) {
+                    std::swap(state[entry.first], entry.second);
+                    notify(entry.first, entry.second);
+                }
+            }
+        }
+
+        for (const auto c : domains) {
+            auto &update = domain_updates[c];
+            update.accepted = 0;
+            update.energy_change = 0.0;
+            update.partner_changes.clear();
+            update.moved.clear();
+        }
+        return accepted;
+    }
+
+    /**
+     * Distance compared against the cutoff of the cell list.
+     */
+    double cell_distance_sq(const ParticleState &a,
+                            const ParticleState &b) const {
+        return periodic_length > 0.0 ? distance_sq(a, b, periodic_length)
+                                     : distance_sq(a, b);
+    }
+
+    /**
+     * Calls f(j) for every particle j != ix interacting with a particle ix
+     * located at p.
+     */
+    template <typename Function>
+    void for_each_partner(const ParticleState &p, size_type ix,
+                          Function f) const {
+        for_each_partner_while(p, ix, [&f](size_type j) {
+            f(j);
+            return true;
+        });
+    }
+
+    /**
+     * Like for_each_partner, but stops as soon as f(j) returns false.
+     * returns: false if stopped by f
+     */
+    template <typename Function>
+    bool for_each_partner_while(const ParticleState &p, size_type ix,
+                                Function f) const {
+        if (listed(p, ix)) {
+            for (auto it = neighbours.begin(ix), end = neighbours.end(ix);
+                 it != end; ++it) {
+                const auto j = *it;
+                if (cell_distance_sq(state[j], p) < cutoff_sq && !f(j)) {
+                    return false;
+                }
             }
+            return true;
+        }
+        if (cell_list) {
+            return cells.for_each_neighbour_while(p, [&](size_type j) {
+                return j == ix || cell_distance_sq(state[j], p) >= cutoff_sq ||
+                       f(j);
+            });
+        }
+        for (size_type j = 0; j < state.size(); ++j) {
+            if (j != ix && !f(j)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Whether the Verlet list of particle ix holds all partners of p.
+     * Otherwise, e.g. for a proposal beyond skin / 2, the cells are scanned.
+     */
+    bool listed(const ParticleState &p, size_type ix) const {
+        return neighbour_list && !neighbours.is_stale() &&
+               neighbours.covers(ix, p);
+    }
+
+    /**
+     * Calculates the potential of particle ix if it were located at p
+     */
+    double potential(const ParticleState &p, size_type ix) const {
+        if (dense()) {
+            return dense_row(p, ix, row_buffer.data());
         }
+        auto potential_energy = 0.0;
+        for_each_partner(p, ix, [&](size_type j) {
+            potential_energy += potential_func(state[j], p);
+        });
         return potential_energy;
     }
 
+    /**
+     * Whether energy rows are evaluated by the row kernel of the potential.
+     * The cell list takes precedence, as it visits only a few particles.
+     */
+    bool dense() const {
+        return HasRowKernel<Potential, ParticleState>::value && !cell_list;
+    }
+
+    /**
+     * Evaluates the energy row of particle ix located at p with the row
+     * kernel of the potential, the pair energies are written to out.
+     */
+    double dense_row(const ParticleState &p, size_type ix, double *out) const {
+        return dense_row(p, ix, out,
+                         HasRowKernel<Potential, ParticleState>());
+    }
+
+    double dense_row(const ParticleState &p, size_type ix, double *out,
+                     std::true_type) const {
+        return potential_func.row(soa, p, ix, out);
+    }
+
+    double dense_row(const ParticleState &, size_type, double *,
+                     std::false_type) const {
+        return 0.0;
+    }
+
+    /**
+     * Lower bound of the energy of all pairs of the state, at most zero so
+     * that it holds for pairs beyond the cutoff as well. The charges do not
+     * change with moves, so the bound stays valid.
+     */
+    double min_pair_energy(std::true_type) const {
+        auto ret = 0.0;
+        for (size_type i = 0; i < state.size(); ++i) {
+            for (size_type j = i + 1; j < state.size(); ++j) {
+                ret = std::min(
+                    ret, potential_func.min_pair_energy(state[i], state[j]));
+            }
+        }
+        return ret;
+    }
+
+    double min_pair_energy(std::false_type) const { return 0.0; }
+
+    /**
+     * Forward to the long-range interface of the potential, see HasLongRange.
+     * Without a long-range part they do nothing.
+     */
+    void reset_long_range(std::true_type) {
+        potential_func.long_range_reset(state);
+    }
+
+    void reset_long_range(std::false_type) {}
+
+    double long_range_trial(const ParticleState &old_pos,
+                            const ParticleState &new_pos, std::true_type) {
+        return potential_func.long_range_trial(old_pos, new_pos);
+    }
+
+    double long_range_trial(const ParticleState &, const ParticleState &,
+                            std::false_type) {
+        return 0.0;
+    }
+
+    void long_range_accept(std::true_type) {
+        potential_func.long_range_accept();
+    }
+
+    void long_range_accept(std::false_type) {}
+
+    double long_range_energy(std::true_type) const {
+        return potential_func.long_range_energy();
+    }
+
+    double long_range_energy(std::false_type) const { return 0.0; }
+
+    /**
+     * The long-range part of the potential belongs to the configuration.
+     */
+    void swap_long_range(CanonicalEnsemble &other, std::true_type) {
+        using std::swap;
+        swap(potential_func, other.potential_func);
+    }
+
+    void swap_long_range(CanonicalEnsemble &, std::false_type) {}
+
+    /**
+     * Moves particle ix to p and keeps the cell list and the SoA copy up to
+     * date.
+     */
+    void move(size_type ix, const ParticleState &p) {
+        state[ix] = p;
+        if (cell_list) {
+            cells.move(ix, p);
+        }
+        if (neighbour_list) {
+            neighbours.move(ix, p);
+        }
+        if (HasRowKernel<Potential, ParticleState>::value) {
+            soa.set(ix, p);
+        }
+    }
+
+    void notify(size_type ix, const ParticleState &old_pos) const {
+        for (const auto &observer : observers) {
+            observer(state, ix, old_pos);
+        }
+    }
+
 private:
-    std::mt19937 rng;
+    Rng rng;
     std::uniform_real_distribution<double> unif_real;
-    std::uniform_int_distribution<typename State::size_type> unif_index;
+    std::uniform_int_distribution<size_type> unif_index;
 
     PotentialFunction potential_func;
     ProposalFunction proposal_func;
@@ -105,6 +1062,34 @@ private:
     State state;
 
     double beta;
+
+    bool energy_cache = false;
+    std::vector<double> energies;
+    std::vector<std::pair<size_type, double>> row;
+    double total_energy = 0.0;
+    // Lower bound of the pair energy, see HasPairFloor
+    double pair_floor = 0.0;
+
+    bool cell_list = false;
+    CellList<ParticleState> cells;
+    double cell_box_length = 0.0;
+    double cutoff_sq = 0.0;
+    double periodic_length = 0.0;
+
+    bool neighbour_list = false;
+    VerletList<ParticleState> neighbours;
+
+    Checkerboard<ParticleState> board;
+    std::vector<Rng> domain_rngs;
+    std::vector<DomainUpdate> domain_updates;
+    // Whether a particle moved during the current colour update
+    std::vector<char> moved_flags;
+
+    SoAState<dim> soa;
+    mutable typename SoAState<dim>::Array row_buffer;
+    typename SoAState<dim>::Array old_row_buffer;
+
+    std::vector<MoveObserver> observers;
 };
 
 #endif // CANONICALENSEMBLE_H_
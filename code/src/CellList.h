@@ -0,0 +1,236 @@
+#ifndef CELLLIST_H_
+#define CELLLIST_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "ParticleTraits.h"
+
+/**
+ * CellList
+ *
+ * Linked-cell spatial index over the simulation box [-L/2, L/2]^dim. The box
+ * is divided into cells with a side length of at least the cutoff, so all
+ * interaction partners of a particle are located in its own or in one of the
+ * directly adjacent cells. In a periodic box the cells adjacent across a wall
+ * are those on the opposite side.
+ */
+template <typename ParticleState>
+class CellList {
+public:
+    using Traits = ParticleTraits<ParticleState>;
+    using size_type = std::size_t;
+
+    static constexpr size_type dim = Traits::dim;
+
+    /**
+     * Marks the end of the particle list of a cell.
+     */
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+public:
+    /**
+     * Constructs an empty index.
+     */
+    CellList() = default;
+
+    /**
+     * Constructor taking the side length of the box, the interaction cutoff,
+     * the particles to index and whether the box is periodic.
+     */
+    CellList(double box_length, double cutoff,
+             const std::vector<ParticleState> &state, bool periodic = false)
+        : limit(box_length / 2.0), periodic(periodic) {
+        const auto n = static_cast<size_type>(std::floor(box_length / cutoff));
+        cells_per_dim = std::max<size_type>(n, 1);
+        inv_width = cells_per_dim / box_length;
+
+        size_type cell_num = 1;
+        for (size_type d = 0; d < dim; ++d) {
+            cell_num *= cells_per_dim;
+        }
+        head.assign(cell_num, npos);
+        occupancy.assign(cell_num, 0);
+        next.assign(state.size(), npos);
+        prev.assign(state.size(), npos);
+        cell.assign(state.size(), 0);
+
+        for (size_type i = 0; i < state.size(); ++i) {
+            insert(i, cell_index(state[i]));
+        }
+    }
+
+    /**
+     * Updates the index after particle ix moved to new_pos.
+     */
+    void move(size_type ix, const ParticleState &new_pos) {
+        const auto c = cell_index(new_pos);
+        if (c != cell[ix]) {
+            remove(ix);
+            insert(ix, c);
+        }
+    }
+
+    /**
+     * Calls f(j) for every particle j located in the cell containing p or in
+     * one of the adjacent cells.
+     */
+    template <typename Function>
+    void for_each_neighbour(const ParticleState &p, Function f) const {
+        for_each_neighbour_while(p, [&f](size_type j) {
+            f(j);
+            return true;
+        });
+    }
+
+    /**
+     * Like for_each_neighbour, but stops as soon as f(j) returns false. The
+     * cell containing p is visited first, so that the nearest particles come
+     * early.
+     * returns: false if stopped by f
+     */
+    template <typename Function>
+    bool for_each_neighbour_while(const ParticleState &p, Function f) const {
+        return for_each_cell_while(p, [&](size_type c) {
+            for (auto j = head[c]; j != npos; j = next[j]) {
+                if (!f(j)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    /**
+     * Number of particles for_each_neighbour visits for p.
+     */
+    size_type neighbour_count(const ParticleState &p) const {
+        size_type ret = 0;
+        for_each_cell_while(p, [&](size_type c) {
+            ret += occupancy[c];
+            return true;
+        });
+        return ret;
+    }
+
+    /**
+     * Number of cells along each axis.
+     */
+    size_type get_cells_per_dim() const { return cells_per_dim; }
+
+private:
+    size_type cell_coordinate(double x) const {
+        const auto c = static_cast<long>(std::floor((x + limit) * inv_width));
+        const auto max = static_cast<long>(cells_per_dim) - 1;
+        return static_cast<size_type>(std::min(std::max(c, 0L), max));
+    }
+
+    size_type cell_index(const ParticleState &p) const {
+        size_type ret = 0;
+        for (size_type d = 0; d < dim; ++d) {
+            ret = ret * cells_per_dim +
+                  cell_coordinate(Traits::coordinate(p, d));
+        }
+        return ret;
+    }
+
+    /**
+     * Calls g(c) for the cell c containing p and then for the adjacent cells
+     * until g returns false.
+     */
+    template <typename Function>
+    bool for_each_cell_while(const ParticleState &p, Function g) const {
+        std::array<size_type, dim> coords;
+        size_type own = 0;
+        for (size_type d = 0; d < dim; ++d) {
+            coords[d] = cell_coordinate(Traits::coordinate(p, d));
+            own = own * cells_per_dim + coords[d];
+        }
+        return g(own) && visit(coords, 0, 0, own, g);
+    }
+
+    /**
+     * Recursively enumerates the adjacent cells along axis d, clipped at the
+     * walls of the box or wrapped around in a periodic box. The cell own has
+     * already been visited.
+     */
+    template <typename Function>
+    bool visit(const std::array<size_type, dim> &coords, size_type d,
+               size_type partial, size_type own, Function &g) const {
+        if (d == dim) {
+            return partial == own || g(partial);
+        }
+        if (periodic && cells_per_dim >= 3) {
+            for (size_type k = 0; k < 3; ++k) {
+                const auto c = (coords[d] + cells_per_dim - 1 + k) %
+                               cells_per_dim;
+                if (!visit(coords, d + 1, partial * cells_per_dim + c, own,
+                           g)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        auto lo = coords[d] > 0 ? coords[d] - 1 : 0;
+        auto hi = std::min(coords[d] + 1, cells_per_dim - 1);
+        if (periodic) {
+            // With less than three cells per axis, all of them are adjacent
+            lo = 0;
+            hi = cells_per_dim - 1;
+        }
+        for (auto c = lo; c <= hi; ++c) {
+            if (!visit(coords, d + 1, partial * cells_per_dim + c, own, g)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void insert(size_type ix, size_type c) {
+        cell[ix] = c;
+        ++occupancy[c];
+        prev[ix] = npos;
+        next[ix] = head[c];
+        if (head[c] != npos) {
+            prev[head[c]] = ix;
+        }
+        head[c] = ix;
+    }
+
+    void remove(size_type ix) {
+        --occupancy[cell[ix]];
+        if (prev[ix] != npos) {
+            next[prev[ix]] = next[ix];
+        } else {
+            head[cell[ix]] = next[ix];
+        }
+        if (next[ix] != npos) {
+            prev[next[ix]] = prev[ix];
+        }
+    }
+
+private:
+    double limit = 0.0;
+    bool periodic = false;
+    double inv_width = 0.0;
+    size_type cells_per_dim = 0;
+
+    std::vector<size_type> head;
+    std::vector<size_type> next;
+    std::vector<size_type> prev;
+    std::vector<size_type> cell;
+    std::vector<size_type> occupancy;
+};
+
+template <typename ParticleState>
+constexpr typename CellList<ParticleState>::size_type
+    CellList<ParticleState>::dim;
+
+template <typename ParticleState>
+constexpr typename CellList<ParticleState>::size_type
+    CellList<ParticleState>::npos;
+
+#endif // CELLLIST_H_
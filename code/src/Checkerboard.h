@@ -0,0 +1,201 @@
+#ifndef CHECKERBOARD_H_
+#define CHECKERBOARD_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include "ParticleTraits.h"
+
+/**
+ * Checkerboard
+ *
+ * Decomposition of the simulation box [-L/2, L/2]^dim into cubic domains of
+ * a side length of at least the cutoff, coloured by the parity of their
+ * coordinates. Two domains of the same colour are separated by at least one
+ * domain, so particles moving inside them do not interact and can be updated
+ * concurrently.
+ *
+ * The grid is shifted by an offset for every assignment, so that particles
+ * cross the domain boundaries over successive sweeps. In a closed box this
+ * needs one domain more per axis than fit into the box, in a periodic box the
+ * number of domains per axis is even so that the colouring survives the
+ * wrap-around.
+ */
+template <typename ParticleState>
+class Checkerboard {
+public:
+    using Traits = ParticleTraits<ParticleState>;
+    using size_type = std::size_t;
+
+    static constexpr size_type dim = Traits::dim;
+
+    /**
+     * Number of colours, each one a parity pattern of the coordinates.
+     */
+    static constexpr size_type colour_count = size_type(1) << dim;
+
+public:
+    Checkerboard() = default;
+
+    /**
+     * Constructor taking the side length of the box, the interaction cutoff
+     * and whether the box is periodic.
+     */
+    Checkerboard(double box_length, double cutoff, bool periodic = false)
+        : limit(box_length / 2.0), periodic(periodic) {
+        auto n = std::max<size_type>(
+            static_cast<size_type>(std::floor(box_length / cutoff)), 1);
+        if (periodic && n > 1) {
+            n -= n % 2;
+        }
+        width = box_length / n;
+        inv_width = 1.0 / width;
+        domains_per_dim = periodic ? n : n + 1;
+
+        size_type domain_num = 1;
+        for (size_type d = 0; d < dim; ++d) {
+            domain_num *= domains_per_dim;
+        }
+        start.assign(domain_num + 1, 0);
+        domain_colours.resize(domain_num);
+        for (size_type c = 0; c < colour_count; ++c) {
+            colours[c].clear();
+        }
+        for (size_type i = 0; i < domain_num; ++i) {
+            domain_colours[i] = colour(i);
+            colours[domain_colours[i]].push_back(i);
+        }
+    }
+
+    /**
+     * Sorts the particles into the domains of the grid shifted by offset,
+     * whose components lie in [0, get_width()).
+     */
+    void assign(const std::vector<ParticleState> &state,
+                const std::array<double, dim> &offset) {
+        this->offset = offset;
+        domain.resize(state.size());
+        std::fill(start.begin(), start.end(), 0);
+        for (size_type i = 0; i < state.size(); ++i) {
+            domain[i] = domain_index(state[i]);
+            ++start[domain[i] + 1];
+        }
+        std::partial_sum(start.begin(), start.end(), start.begin());
+
+        // Counting sort, the members of a domain keep increasing indices
+        order.resize(state.size());
+        auto fill = start;
+        for (size_type i = 0; i < state.size(); ++i) {
+            order[fill[domain[i]]++] = i;
+        }
+    }
+
+    /**
+     * Domains of a colour.
+     */
+    const std::vector<size_type> &domains(size_type colour) const {
+        return colours[colour];
+    }
+
+    /**
+     * Colour of domain c.
+     */
+    size_type colour_of(size_type c) const { return domain_colours[c]; }
+
+    /**
+     * Particles assigned to domain c: the range [begin, end) of indices.
+     */
+    const size_type *begin(size_type c) const {
+        return order.data() + start[c];
+    }
+
+    const size_type *end(size_type c) const {
+        return order.data() + start[c + 1];
+    }
+
+    size_type size(size_type c) const { return start[c + 1] - start[c]; }
+
+    /**
+     * Domain particle ix was assigned to.
+     */
+    size_type domain_of(size_type ix) const { return domain[ix]; }
+
+    /**
+     * Whether p lies in domain c of the current grid.
+     */
+    bool contains(size_type c, const ParticleState &p) const {
+        return domain_index(p) == c;
+    }
+
+    size_type domain_count() const {
+        return start.empty() ? 0 : start.size() - 1;
+    }
+
+    /**
+     * Side length of the domains, the range of the offsets.
+     */
+    double get_width() const { return width; }
+
+private:
+    size_type domain_coordinate(double x, size_type d) const {
+        const auto c =
+            static_cast<long>(std::floor((x + limit + offset[d]) * inv_width));
+        if (periodic) {
+            const auto n = static_cast<long>(domains_per_dim);
+            return static_cast<size_type>(((c % n) + n) % n);
+        }
+        const auto max = static_cast<long>(domains_per_dim) - 1;
+        return static_cast<size_type>(std::min(std::max(c, 0L), max));
+    }
+
+    size_type domain_index(const ParticleState &p) const {
+        size_type ret = 0;
+        for (size_type d = 0; d < dim; ++d) {
+            ret = ret * domains_per_dim +
+                  domain_coordinate(Traits::coordinate(p, d), d);
+        }
+        return ret;
+    }
+
+    /**
+     * Colour of domain c: bit d holds the parity of its coordinate d.
+     */
+    size_type colour(size_type c) const {
+        size_type ret = 0;
+        for (size_type d = 0; d < dim; ++d) {
+            ret |= (c % domains_per_dim % 2) << d;
+            c /= domains_per_dim;
+        }
+        return ret;
+    }
+
+private:
+    double limit = 0.0;
+    bool periodic = false;
+    double width = 0.0;
+    double inv_width = 0.0;
+    size_type domains_per_dim = 0;
+    std::array<double, dim> offset{};
+
+    std::array<std::vector<size_type>, colour_count> colours;
+    std::vector<size_type> domain_colours;
+    // Particles sorted by domain, those of domain c are
+    // order[start[c]] ... order[start[c + 1] - 1]
+    std::vector<size_type> order;
+    std::vector<size_type> start;
+    std::vector<size_type> domain;
+};
+
+template <typename ParticleState>
+constexpr typename Checkerboard<ParticleState>::size_type
+    Checkerboard<ParticleState>::dim;
+
+template <typename ParticleState>
+constexpr typename Checkerboard<ParticleState>::size_type
+    Checkerboard<ParticleState>::colour_count;
+
+#endif // CHECKERBOARD_H_
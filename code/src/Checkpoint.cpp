@@ -0,0 +1,117 @@
+#include "Checkpoint.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char checkpoint_magic[8] = {'P', 'I', 'A', 'P', 'C', 'K', 'P', '\0'};
+const std::uint32_t checkpoint_version = 3;
+
+/**
+ * Writes data to a new file and waits until it is on disk.
+ */
+bool write_durably(const std::string &filename, const std::string &data) {
+#ifdef _WIN32
+    auto file = CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD written = 0;
+    const auto ok = WriteFile(file, data.data(),
+                              static_cast<DWORD>(data.size()), &written,
+                              nullptr) &&
+                    written == data.size() && FlushFileBuffers(file);
+    CloseHandle(file);
+    return ok;
+#else
+    const auto fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    auto ok = true;
+    for (std::size_t offset = 0; ok && offset < data.size();) {
+        const auto n = write(fd, data.data() + offset, data.size() - offset);
+        ok = n > 0;
+        offset += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+/**
+ * Replaces to by from in a single step and waits until the new directory
+ * entry is on disk.
+ */
+bool replace_file(const std::string &from, const std::string &to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    if (std::rename(from.c_str(), to.c_str()) != 0) {
+        return false;
+    }
+    // The rename only survives a power loss once the directory is synced
+    const auto slash = to.find_last_of('/');
+    const auto directory = slash == std::string::npos ? std::string(".")
+                           : slash == 0 ? std::string("/")
+                                        : to.substr(0, slash);
+    const auto fd = open(directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // Some file systems cannot sync directories and report EINVAL
+    const auto ok = fsync(fd) == 0 || errno == EINVAL;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+} // namespace
+
+bool write_checkpoint(const std::string &filename,
+                      const std::function<void(std::ostream &)> &write) {
+    std::ostringstream os;
+    os.write(checkpoint_magic, sizeof(checkpoint_magic));
+    os.write(reinterpret_cast<const char *>(&checkpoint_version),
+             sizeof(checkpoint_version));
+    write(os);
+
+    const auto tmp = filename + ".tmp";
+    if (!os || !write_durably(tmp, os.str())) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return replace_file(tmp, filename);
+}
+
+bool read_checkpoint(const std::string &filename,
+                     const std::function<bool(std::istream &)> &read) {
+    std::ifstream is(filename, std::ios::binary);
+    char magic[sizeof(checkpoint_magic)];
+    std::uint32_t version = 0;
+    is.read(magic, sizeof(magic));
+    is.read(reinterpret_cast<char *>(&version), sizeof(version));
+    return is && std::memcmp(magic, checkpoint_magic, sizeof(magic)) == 0 &&
+           version == checkpoint_version && read(is);
+}
+
+bool checkpoint_exists(const std::string &filename) {
+    return std::ifstream(filename).good();
+}
+
+void remove_checkpoint(const std::string &filename) {
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,49 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+/**
+ * Checkpoint files
+ *
+ *     magic    8 bytes
+ *     version  uint32
+ *     payload  written by the save() members of the checkpointed objects
+ *
+ * All values are stored in native byte order. A checkpoint is written to a
+ * temporary file, flushed to disk and renamed over the previous one, whose
+ * directory is flushed as well, so that a crash leaves either the old or the
+ * new checkpoint, never a partial one.
+ */
+
+/**
+ * Writes a checkpoint whose payload is produced by write.
+ *
+ * returns: bool - false if the file could not be written.
+ */
+bool write_checkpoint(const std::string &filename,
+                      const std::function<void(std::ostream &)> &write);
+
+/**
+ * Reads a checkpoint, checking magic and version before passing the payload
+ * to read.
+ *
+ * returns: bool - false if the file does not exist, is not a checkpoint or
+ *          read returns false.
+ */
+bool read_checkpoint(const std::string &filename,
+                     const std::function<bool(std::istream &)> &read);
+
+/**
+ * Whether a file of the given name exists.
+ */
+bool checkpoint_exists(const std::string &filename);
+
+/**
+ * Deletes a checkpoint that is no longer needed.
+ */
+void remove_checkpoint(const std::string &filename);
+
+#endif // CHECKPOINT_H_
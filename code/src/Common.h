@@ -1,20 +1,130 @@
 #ifndef COMMON_H_
 #define COMMON_H_
 
+#include <array>
+#include <cstddef>
 #include <functional>
+#include <random>
+#include <vector>
+
+#include "Boundary.h"
 #include "Particle.h"
+#include "Random.h"
+
+/**
+ * Uniform proposal in a D-dimensional box with side length: 2 * delta.
+ * Particles are kept inside the simulation box according to the boundary:
+ * hard walls redraw offending coordinates, periodic boundaries wrap them
+ * around and reflecting walls mirror them, the latter two with a fixed number
+ * of random draws. Used as compile-time proposal policy of CanonicalEnsemble.
+ */
+template <std::size_t D>
+class UniformProposal {
+public:
+    UniformProposal(double delta, double box_length,
+                    Boundary boundary = Boundary::hard)
+        : unif_dist(-delta, delta), limit(box_length / 2.0),
+          box_length(box_length), inv_box_length(1.0 / box_length),
+          boundary(boundary) {}
+
+    template <typename Generator>
+    Particle<D> operator()(const Particle<D> &p, Generator &rng) {
+        auto ret = p;
+
+        switch (boundary) {
+        case Boundary::periodic:
+            for (std::size_t d = 0; d < D; ++d) {
+                ret.x[d] = wrap(p.x[d] + unif_dist(rng));
+            }
+            break;
+        case Boundary::reflecting:
+            for (std::size_t d = 0; d < D; ++d) {
+                ret.x[d] = reflect(p.x[d] + unif_dist(rng), limit);
+            }
+            break;
+        default:
+            for (std::size_t d = 0; d < D; ++d) {
+                do {
+                    ret.x[d] = p.x[d] + unif_dist(rng);
+                } while (ret.x[d] < -limit || ret.x[d] > limit);
+            }
+        }
+
+        return ret;
+    }
+
+    /**
+     * Half side length of the box around the particle.
+     */
+    double get_delta() const { return unif_dist.b(); }
+
+    void set_delta(double delta) {
+        unif_dist.param(
+            std::uniform_real_distribution<>::param_type(-delta, delta));
+    }
+
+private:
+    double wrap(double x) const {
+        return minimum_image(x, box_length, inv_box_length);
+    }
+
+private:
+    std::uniform_real_distribution<> unif_dist;
+    double limit;
+    double box_length;
+    double inv_box_length;
+    Boundary boundary;
+};
+
+using UniformProposal2D = UniformProposal<2>;
+using UniformProposal3D = UniformProposal<3>;
+
+/**
+ * Uniform proposal function in a D-dimensional box with side length:
+ * 2 * delta.
+ */
+template <std::size_t D>
+std::function<Particle<D>(const Particle<D> &, std::mt19937 &)>
+unif_proposal_function(double delta, double box_length,
+                       Boundary boundary = Boundary::hard) {
+    return UniformProposal<D>(delta, box_length, boundary);
+}
+
+/**
+ * Creates a state with uniformly distributed particles in a D-dimensional
+ * box with side length box_length, drawn from the given stream.
+ */
+template <std::size_t D>
+std::vector<Particle<D>> random_state(double box_length, unsigned pair_num,
+                                      const Seed &seed) {
+    auto rng = make_rng<std::mt19937>(seed);
+
+    std::vector<Particle<D>> ret;
+    std::uniform_real_distribution<> unif(-box_length / 2.0, box_length / 2.0);
+    std::array<double, D> x;
+
+    for (unsigned i = 0; i < 2 * pair_num; ++i) {
+        for (auto &coord : x) {
+            coord = unif(rng);
+        }
+        ret.emplace_back(i % 2 == 0 ? 1.0 : -1.0, x);
+    }
+    return ret;
+}
 
 /**
  * Uniform proposal function in 2d-box with side length: 2 * delta.
  */
 std::function<Particle2D(const Particle2D &, std::mt19937 &)>
-unif_proposal_function(double delta, double box_length);
+unif_proposal_function(double delta, double box_length,
+                       Boundary boundary = Boundary::hard);
 
 /**
  * Uniform proposal function in 3d-box with side length: 2 * delta.
  */
 std::function<Particle3D(const Particle3D &, std::mt19937 &)>
-unif_proposal_function_3d(double delta, double box_length);
+unif_proposal_function_3d(double delta, double box_length,
+                          Boundary boundary = Boundary::hard);
 
 /**
  * Creates a state with uniformly distributed particles in a 2d-box with side
@@ -22,10 +132,22 @@ unif_proposal_function_3d(double delta, double box_length);
  */
 std::vector<Particle2D> random_state(double box_length, unsigned pair_num);
 
+/**
+ * Reproducible version of random_state, drawing from the given stream.
+ */
+std::vector<Particle2D> random_state(double box_length, unsigned pair_num,
+                                     const Seed &seed);
+
 /**
  * Creates a state with uniformly distributed particles in a 3d-box with side
  * length 2 * delta.
  */
 std::vector<Particle3D> random_state_3d(double box_length, unsigned pair_num);
 
+/**
+ * Reproducible version of random_state_3d, drawing from the given stream.
+ */
+std::vector<Particle3D> random_state_3d(double box_length, unsigned pair_num,
+                                        const Seed &seed);
+
 #endif // COMMON_H_
@@ -0,0 +1,581 @@
+#ifndef EWALD_H_
+#define EWALD_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "ParticleTraits.h"
+#include "PotentialKernels.h"
+
+/**
+ * Weight g(k) of the reciprocal Ewald energy
+ *     E_rec = sum_{k != 0} g(k) |S(k)|^2,  S(k) = sum_j q_j exp(i k r_j)
+ * of charges interacting via 1/r in a periodic box with side length L, as a
+ * function of the squared wave vector k2. The charge distribution is assumed
+ * to be neutral. In 3d the box is periodic along all axes. In 2d the charges
+ * form a periodic plane interacting via the 3d Coulomb potential, whose
+ * in-plane Fourier transform gives the erfc form of the 2d Ewald sum.
+ */
+template <std::size_t Dim>
+double ewald_influence(double k2, double alpha, double box_length);
+
+template <>
+inline double ewald_influence<2>(double k2, double alpha, double box_length) {
+    const auto k = std::sqrt(k2);
+    return M_PI / (box_length * box_length) * std::erfc(0.5 * k / alpha) / k;
+}
+
+template <>
+inline double ewald_influence<3>(double k2, double alpha, double box_length) {
+    const auto volume = box_length * box_length * box_length;
+    return 2.0 * M_PI / volume * std::exp(-0.25 * k2 / (alpha * alpha)) / k2;
+}
+
+/**
+ * Self energy of the screening charge distributions, part of the long-range
+ * energy in both 2d and 3d.
+ */
+template <typename ParticleState>
+double ewald_self_energy(const std::vector<ParticleState> &state,
+                         double alpha) {
+    auto q2 = 0.0;
+    for (const auto &p : state) {
+        q2 += p.q * p.q;
+    }
+    return -alpha / std::sqrt(M_PI) * q2;
+}
+
+template <std::size_t Dim>
+class SmoothPME;
+
+/**
+ * EwaldSum
+ *
+ * Reciprocal part of the Ewald sum evaluated directly over the wave vectors
+ * k = 2 pi n / L with |n| <= kmax. Only one of k and -k is stored, as
+ * S(-k) = conj(S(k)). The structure factors are kept up to date under single
+ * particle moves, so that the energy change of a move costs O(K) instead of
+ * O(N K). A full evaluation may take them from the mesh of SmoothPME instead.
+ */
+template <std::size_t Dim>
+class EwaldSum {
+public:
+    /**
+     * Constructs an empty sum.
+     */
+    EwaldSum() = default;
+
+    /**
+     * Constructor taking the side length of the box, the splitting
+     * parameter alpha (the inverse width of the screening Gaussians) and the
+     * cutoff of the wave vectors in units of 2 pi / L.
+     */
+    EwaldSum(double box_length, double alpha, int kmax)
+        : box_length(box_length), alpha(alpha), kmax(kmax) {
+        std::array<int, Dim> n;
+        enumerate(n, 0);
+        s_re.assign(weights.size(), 0.0);
+        s_im.assign(weights.size(), 0.0);
+        d_re.assign(weights.size(), 0.0);
+        d_im.assign(weights.size(), 0.0);
+    }
+
+    /**
+     * Recomputes the structure factors of the state from scratch.
+     */
+    template <typename ParticleState>
+    void reset(const std::vector<ParticleState> &state) {
+        std::fill(s_re.begin(), s_re.end(), 0.0);
+        std::fill(s_im.begin(), s_im.end(), 0.0);
+        for (const auto &p : state) {
+            phases(p);
+            for (std::size_t k = 0; k < weights.size(); ++k) {
+                s_re[k] += p.q * phase_re[k];
+                s_im[k] += p.q * phase_im[k];
+            }
+        }
+        reciprocal = 0.0;
+        for (std::size_t k = 0; k < weights.size(); ++k) {
+            reciprocal += weights[k] * (s_re[k] * s_re[k] + s_im[k] * s_im[k]);
+        }
+        self = ewald_self_energy(state, alpha);
+    }
+
+    /**
+     * Takes the structure factors of the state from the mesh, which has to
+     * be reset to it. Only the full evaluation uses the mesh, the moves
+     * update the structure factors as before.
+     */
+    template <typename ParticleState>
+    void reset(const std::vector<ParticleState> &state,
+               const SmoothPME<Dim> &mesh) {
+        reciprocal = 0.0;
+        std::array<int, Dim> n;
+        for (std::size_t k = 0; k < weights.size(); ++k) {
+            for (std::size_t d = 0; d < Dim; ++d) {
+                n[d] = static_cast<int>(indices[k * Dim + d]) - kmax;
+            }
+            const auto factor = mesh.structure_factor(n);
+            s_re[k] = factor.real();
+            s_im[k] = factor.imag();
+            reciprocal += weights[k] * (s_re[k] * s_re[k] + s_im[k] * s_im[k]);
+        }
+        self = ewald_self_energy(state, alpha);
+    }
+
+    /**
+     * Energy change of moving a particle from old_pos to new_pos. The change
+     * of the structure factors is kept until the next trial, accept() applies
+     * it.
+     */
+    template <typename ParticleState>
+    double trial(const ParticleState &old_pos, const ParticleState &new_pos) {
+        phases(new_pos);
+        for (std::size_t k = 0; k < weights.size(); ++k) {
+            d_re[k] = new_pos.q * phase_re[k];
+            d_im[k] = new_pos.q * phase_im[k];
+        }
+        phases(old_pos);
+        trial_delta = 0.0;
+        for (std::size_t k = 0; k < weights.size(); ++k) {
+            d_re[k] -= old_pos.q * phase_re[k];
+            d_im[k] -= old_pos.q * phase_im[k];
+            trial_delta +=
+                weights[k] * (d_re[k] * (2.0 * s_re[k] + d_re[k]) +
+                              d_im[k] * (2.0 * s_im[k] + d_im[k]));
+        }
+        return trial_delta;
+    }
+
+    /**
+     * Applies the move of the last trial.
+     */
+    void accept() {
+        for (std::size_t k = 0; k < weights.size(); ++k) {
+            s_re[k] += d_re[k];
+            s_im[k] += d_im[k];
+        }
+        reciprocal += trial_delta;
+    }
+
+    /**
+     * Long-range energy: reciprocal sum and self energy.
+     */
+    double energy() const { return reciprocal + self; }
+
+    /**
+     * Number of stored wave vectors.
+     */
+    std::size_t size() const { return weights.size(); }
+
+private:
+    /**
+     * Enumerates the integer vectors n of the half space whose first
+     * non-zero component is positive.
+     */
+    void enumerate(std::array<int, Dim> &n, std::size_t d) {
+        if (d == Dim) {
+            auto n2 = 0;
+            auto sign = 0;
+            for (std::size_t e = 0; e < Dim; ++e) {
+                n2 += n[e] * n[e];
+                if (sign == 0) {
+                    sign = n[e];
+                }
+            }
+            if (sign <= 0 || n2 > kmax * kmax) {
+                return;
+            }
+            const auto k = 2.0 * M_PI / box_length;
+            // Factor 2 accounts for -k
+            weights.push_back(
+                2.0 * ewald_influence<Dim>(k * k * n2, alpha, box_length));
+            for (std::size_t e = 0; e < Dim; ++e) {
+                indices.push_back(n[e] + kmax);
+            }
+            return;
+        }
+        for (n[d] = -kmax; n[d] <= kmax; ++n[d]) {
+            enumerate(n, d + 1);
+        }
+    }
+
+    /**
+     * Computes exp(i k r) of all wave vectors from per-axis tables of the
+     * powers of exp(i 2 pi x / L).
+     */
+    template <typename ParticleState>
+    void phases(const ParticleState &p) {
+        using Traits = ParticleTraits<ParticleState>;
+        const auto width = static_cast<std::size_t>(2 * kmax + 1);
+        table_re.resize(Dim * width);
+        table_im.resize(Dim * width);
+        for (std::size_t d = 0; d < Dim; ++d) {
+            const auto theta =
+                2.0 * M_PI * Traits::coordinate(p, d) / box_length;
+            auto *re = &table_re[d * width + kmax];
+            auto *im = &table_im[d * width + kmax];
+            re[0] = 1.0;
+            im[0] = 0.0;
+            const auto c = std::cos(theta);
+            const auto s = std::sin(theta);
+            for (int n = 1; n <= kmax; ++n) {
+                re[n] = re[n - 1] * c - im[n - 1] * s;
+                im[n] = re[n - 1] * s + im[n - 1] * c;
+                re[-n] = re[n];
+                im[-n] = -im[n];
+            }
+        }
+
+        phase_re.resize(weights.size());
+        phase_im.resize(weights.size());
+        for (std::size_t k = 0; k < weights.size(); ++k) {
+            const auto *n = &indices[k * Dim];
+            auto re = table_re[n[0]];
+            auto im = table_im[n[0]];
+            for (std::size_t d = 1; d < Dim; ++d) {
+                const auto t_re = table_re[d * width + n[d]];
+                const auto t_im = table_im[d * width + n[d]];
+                const auto tmp = re * t_re - im * t_im;
+                im = re * t_im + im * t_re;
+                re = tmp;
+            }
+            phase_re[k] = re;
+            phase_im[k] = im;
+        }
+    }
+
+private:
+    double box_length = 0.0;
+    double alpha = 0.0;
+    int kmax = 0;
+
+    // Weights 2 g(k) and offset integer components n + kmax of the wave
+    // vectors
+    std::vector<double> weights;
+    std::vector<std::size_t> indices;
+
+    std::vector<double> s_re;
+    std::vector<double> s_im;
+    double reciprocal = 0.0;
+    double self = 0.0;
+
+    // Structure factor change and energy change of the last trial
+    std::vector<double> d_re;
+    std::vector<double> d_im;
+    double trial_delta = 0.0;
+
+    // Scratch space of phases()
+    std::vector<double> table_re;
+    std::vector<double> table_im;
+    std::vector<double> phase_re;
+    std::vector<double> phase_im;
+};
+
+/**
+ * In-place radix-2 FFT of n complex values located stride apart. n has to be
+ * a power of two.
+ */
+inline void fft(std::complex<double> *data, std::size_t n,
+                std::size_t stride) {
+    for (std::size_t i = 1, j = 0; i < n; ++i) {
+        auto bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i * stride], data[j * stride]);
+        }
+    }
+    for (std::size_t len = 2; len <= n; len <<= 1) {
+        const auto angle = -2.0 * M_PI / static_cast<double>(len);
+        const std::complex<double> w_len(std::cos(angle), std::sin(angle));
+        for (std::size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0, 0.0);
+            for (std::size_t j = 0; j < len / 2; ++j) {
+                auto &a = data[(i + j) * stride];
+                auto &b = data[(i + j + len / 2) * stride];
+                const auto t = w * b;
+                b = a - t;
+                a += t;
+                w *= w_len;
+            }
+        }
+    }
+}
+
+/**
+ * SmoothPME
+ *
+ * Structure factors of the smooth particle-mesh Ewald method (Essmann et al.
+ * 1995): the charges are spread onto a mesh with cardinal B-splines of the
+ * given (even) order, the structure factors follow from a FFT of the mesh,
+ * and the B-spline moduli correct for the interpolation. They cost
+ * O(N + M log M) for M mesh points instead of the O(N K) of EwaldSum::reset,
+ * at the price of an interpolation error. The number of mesh points per axis
+ * has to be a power of two.
+ */
+template <std::size_t Dim>
+class SmoothPME {
+public:
+    /**
+     * Constructs an empty mesh.
+     */
+    SmoothPME() = default;
+
+    /**
+     * Constructor taking the side length of the box, the number of mesh
+     * points per axis and the order of the B-splines.
+     */
+    SmoothPME(double box_length, std::size_t mesh, std::size_t order = 6)
+        : box_length(box_length), mesh(mesh), order(order) {
+        std::size_t size = 1;
+        for (std::size_t d = 0; d < Dim; ++d) {
+            size *= mesh;
+        }
+        factors.resize(size);
+
+        // Inverse B-spline moduli along one axis, times the phase (-1)^m of
+        // the shift of the box to the mesh origin
+        std::vector<double> spline(order);
+        weights(0.0, spline.data());
+        correction.resize(mesh);
+        for (std::size_t m = 0; m < mesh; ++m) {
+            std::complex<double> sum(0.0, 0.0);
+            for (std::size_t l = 1; l < order; ++l) {
+                const auto angle = -2.0 * M_PI * m * l / mesh;
+                sum += spline[l] *
+                       std::complex<double>(std::cos(angle), std::sin(angle));
+            }
+            correction[m] = (m % 2 == 0 ? 1.0 : -1.0) / sum;
+        }
+    }
+
+    /**
+     * Spreads the charges of the state onto the mesh and transforms it.
+     */
+    template <typename ParticleState>
+    void reset(const std::vector<ParticleState> &state) {
+        std::fill(factors.begin(), factors.end(),
+                  std::complex<double>(0.0, 0.0));
+
+        // Spread the charges, axis 0 varies fastest
+        for (const auto &p : state) {
+            splines(p);
+            spread(p.q, Dim, 0);
+        }
+
+        // Transform along every axis
+        std::size_t stride = 1;
+        const auto size = factors.size();
+        for (std::size_t d = 0; d < Dim; ++d) {
+            for (std::size_t i = 0; i < size; ++i) {
+                if ((i / stride) % mesh == 0) {
+                    fft(&factors[i], mesh, stride);
+                }
+            }
+            stride *= mesh;
+        }
+    }
+
+    /**
+     * Structure factor S(k) of the wave vector k = 2 pi n / L, interpolated
+     * from the mesh. Accurate for |n_d| well below half the mesh points per
+     * axis.
+     */
+    std::complex<double>
+    structure_factor(const std::array<int, Dim> &n) const {
+        std::size_t index = 0;
+        std::complex<double> c(1.0, 0.0);
+        for (auto d = Dim; d-- > 0;) {
+            const auto m = static_cast<std::size_t>(
+                n[d] < 0 ? n[d] + static_cast<int>(mesh) : n[d]);
+            index = index * mesh + m;
+            c *= correction[m];
+        }
+        return std::conj(factors[index]) * c;
+    }
+
+    /**
+     * Number of mesh points.
+     */
+    std::size_t size() const { return factors.size(); }
+
+private:
+    /**
+     * Values M(w + j), j = 0 ... order - 1, of the cardinal B-spline for a
+     * fractional offset w, which weight the mesh points floor(u) - j.
+     */
+    void weights(double w, double *out) const {
+        out[0] = w;
+        out[1] = 1.0 - w;
+        for (std::size_t n = 3; n <= order; ++n) {
+            out[n - 1] = 0.0;
+            for (auto j = n - 1; j > 0; --j) {
+                out[j] = ((w + j) * out[j] + (n - w - j) * out[j - 1]) /
+                         (n - 1);
+            }
+            out[0] = w * out[0] / (n - 1);
+        }
+    }
+
+    /**
+     * Computes the B-spline weights of p along every axis and the mesh
+     * points they start from.
+     */
+    template <typename ParticleState>
+    void splines(const ParticleState &p) {
+        using Traits = ParticleTraits<ParticleState>;
+        spline.resize(Dim * order);
+        for (std::size_t d = 0; d < Dim; ++d) {
+            const auto x = Traits::coordinate(p, d) / box_length + 0.5;
+            const auto u = mesh * (x - std::floor(x));
+            const auto cell = std::floor(u);
+            weights(u - cell, &spline[d * order]);
+            base[d] = static_cast<std::size_t>(cell) % mesh;
+        }
+    }
+
+    /**
+     * Adds the charge q weighted with the product of the splines to the mesh
+     * points around base, recursing over the axes from the slowest one.
+     */
+    void spread(double q, std::size_t d, std::size_t offset) {
+        if (d == 0) {
+            factors[offset] += q;
+            return;
+        }
+        --d;
+        for (std::size_t j = 0; j < order; ++j) {
+            const auto m = (base[d] + mesh - j) % mesh;
+            spread(q * spline[d * order + j], d, offset * mesh + m);
+        }
+    }
+
+private:
+    double box_length = 0.0;
+    std::size_t mesh = 0;
+    std::size_t order = 0;
+
+    // Transformed mesh and the correction of its structure factors along
+    // one axis
+    std::vector<std::complex<double>> factors;
+    std::vector<std::complex<double>> correction;
+
+    // Scratch space of splines()
+    std::vector<double> spline;
+    std::array<std::size_t, Dim> base{};
+};
+
+/**
+ * Evaluation of the structure factors in a full evaluation of the reciprocal
+ * part: directly over the wave vectors (EwaldSum) or on a mesh (SmoothPME).
+ */
+enum class LongRange { ewald, pme };
+
+/**
+ * EwaldCoulombCore
+ *
+ * coulomb_core in a periodic box with side length L. The Coulomb term is
+ * split into a screened real-space pair potential, evaluated with minimum
+ * image distances and meant to be combined with a periodic cell list of the
+ * given cutoff, and a long-range part summed in reciprocal space (see
+ * EwaldSum). alpha and the wave vector cutoff are chosen such that both
+ * truncated sums are accurate to about the given relative accuracy. Used as
+ * compile-time potential policy of CanonicalEnsemble, which keeps the
+ * structure factors up to date through the long-range interface
+ *     void long_range_reset(const std::vector<ParticleState> &),
+ *     double long_range_trial(const ParticleState &old_pos,
+ *                             const ParticleState &new_pos),
+ *     void long_range_accept(),
+ *     double long_range_energy() const.
+ */
+template <typename ParticleState>
+class EwaldCoulombCore {
+public:
+    static constexpr std::size_t dim = ParticleTraits<ParticleState>::dim;
+
+public:
+    /**
+     * Constructor taking the side length of the box, the real-space cutoff,
+     * the relative accuracy and the evaluation of the structure factors in
+     * long_range_reset(). The mesh, which resolves the wave vectors up to
+     * twice the cutoff, makes it cheap for many particles. Single particle
+     * moves cost O(K) for K wave vectors either way, see bench_ewald.
+     */
+    EwaldCoulombCore(double box_length, double cutoff, double accuracy = 1e-5,
+                     LongRange long_range = LongRange::ewald)
+        : box_length(box_length),
+          alpha(std::sqrt(-std::log(accuracy)) / cutoff),
+          mesh(long_range == LongRange::pme) {
+        const auto kmax = static_cast<int>(std::ceil(
+            alpha * box_length / M_PI * std::sqrt(-std::log(accuracy))));
+        ewald = EwaldSum<dim>(box_length, alpha, kmax);
+        if (mesh) {
+            std::size_t points = 2;
+            while (points < static_cast<std::size_t>(4 * kmax)) {
+                points *= 2;
+            }
+            pme = SmoothPME<dim>(box_length, points);
+        }
+    }
+
+    double operator()(const ParticleState &a, const ParticleState &b) const {
+        return ewald_core_kernel(distance_sq(a, b, box_length), a.q * b.q,
+                                 alpha);
+    }
+
+    /**
+     * Lower bound of the pair energy, used for early rejection. The screened
+     * Coulomb term is bounded by the bare one.
+     */
+    double min_pair_energy(const ParticleState &a,
+                           const ParticleState &b) const {
+        return coulomb_core_min(a.q * b.q);
+    }
+
+    void long_range_reset(const std::vector<ParticleState> &state) {
+        if (mesh) {
+            pme.reset(state);
+            ewald.reset(state, pme);
+        } else {
+            ewald.reset(state);
+        }
+    }
+
+    double long_range_trial(const ParticleState &old_pos,
+                            const ParticleState &new_pos) {
+        return ewald.trial(old_pos, new_pos);
+    }
+
+    void long_range_accept() { ewald.accept(); }
+
+    double long_range_energy() const { return ewald.energy(); }
+
+    double get_alpha() const { return alpha; }
+
+    /**
+     * Number of wave vectors.
+     */
+    std::size_t long_range_size() const { return ewald.size(); }
+
+    /**
+     * Number of mesh points, zero without mesh.
+     */
+    std::size_t mesh_size() const { return mesh ? pme.size() : 0; }
+
+private:
+    double box_length;
+    double alpha;
+    bool mesh;
+    EwaldSum<dim> ewald;
+    SmoothPME<dim> pme;
+};
+
+#endif // EWALD_H_
@@ -0,0 +1,167 @@
+#ifndef HYBRIDMONTECARLO_H_
+#define HYBRIDMONTECARLO_H_
+
+#include <cmath>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include "BinaryIO.h"
+#include "Boundary.h"
+#include "ParticleTraits.h"
+#include "Random.h"
+
+/**
+ * HybridMonteCarlo
+ *
+ * Collective move of all particles of a CanonicalEnsemble, to be mixed with
+ * its single particle steps. Momenta are drawn from the Maxwell distribution
+ * at unit mass, the configuration follows a leapfrog trajectory under the
+ * forces of the potential (see CanonicalEnsemble::forces) and its end point
+ * is accepted with probability min(1, exp(-beta * dH)), where H is the sum
+ * of potential and kinetic energy. Leapfrog is reversible and volume
+ * preserving, so the move leaves the canonical distribution invariant for
+ * every step size, which only sets the acceptance rate.
+ *
+ * Particles are kept in the box: periodic boxes wrap the positions, closed
+ * boxes (hard and reflecting walls alike) mirror a particle at the wall and
+ * reverse the normal component of its momentum, which retains both
+ * properties of the trajectory.
+ */
+template <typename Ensemble>
+class HybridMonteCarlo {
+public:
+    using State = typename Ensemble::State;
+    using ParticleState = typename State::value_type;
+    using Force = typename Ensemble::Force;
+
+public:
+    /**
+     * Constructor taking the step size and the number of leapfrog steps of a
+     * trajectory, the box and the seed of the momenta and the decisions.
+     */
+    HybridMonteCarlo(double step_size, std::size_t n_leapfrog,
+                     double box_length, Boundary boundary,
+                     const Seed &seed = random_seed())
+        : step_size(step_size), n_leapfrog(n_leapfrog),
+          limit(box_length / 2.0), box_length(box_length),
+          periodic(boundary == Boundary::periodic),
+          rng(make_rng<std::mt19937>(seed)) {}
+
+    /**
+     * Executes a trajectory of the configuration of the ensemble.
+     *
+     * returns: bool - indicating whether the trajectory was accepted.
+     */
+    bool step(Ensemble &ensemble) {
+        using Traits = ParticleTraits<ParticleState>;
+        const auto beta = ensemble.get_beta();
+        trial = ensemble.get_state();
+        const auto n = trial.size();
+
+        std::normal_distribution<double> maxwell(0.0, 1.0 / std::sqrt(beta));
+        momenta.resize(n);
+        auto kinetic = 0.0;
+        for (auto &p : momenta) {
+            for (auto &x : p) {
+                x = maxwell(rng);
+                kinetic += 0.5 * x * x;
+            }
+        }
+
+        const auto initial_pot = ensemble.forces(trial, forces);
+        auto pot = initial_pot;
+        const auto half_step = 0.5 * step_size;
+        double x[Traits::dim];
+        for (std::size_t k = 0; k < n_leapfrog; ++k) {
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t d = 0; d < Traits::dim; ++d) {
+                    momenta[i][d] += half_step * forces[i][d];
+                    x[d] = drift(Traits::coordinate(trial[i], d),
+                                 momenta[i][d]);
+                }
+                trial[i] = Traits::make(trial[i].q, x);
+            }
+            pot = ensemble.forces(trial, forces);
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t d = 0; d < Traits::dim; ++d) {
+                    momenta[i][d] += half_step * forces[i][d];
+                }
+            }
+        }
+
+        auto final_kinetic = 0.0;
+        for (const auto &p : momenta) {
+            for (const auto x : p) {
+                final_kinetic += 0.5 * x * x;
+            }
+        }
+
+        // A diverging trajectory gives a NaN, which is rejected as well
+        const auto accept_prob = std::exp(
+            -beta * (pot - initial_pot + final_kinetic - kinetic));
+        const auto accepted = unif_real(rng) < accept_prob;
+        if (accepted) {
+            ensemble.set_configuration(trial);
+        }
+        return accepted;
+    }
+
+    double get_step_size() const { return step_size; }
+
+    void set_step_size(double step_size) { this->step_size = step_size; }
+
+    /**
+     * Writes step size and random number generator for a checkpoint.
+     */
+    void save(std::ostream &os) const {
+        write_binary(os, step_size);
+        write_engine(os, rng);
+    }
+
+    /**
+     * Restores the state written by save().
+     * returns: false if the stream does not hold it
+     */
+    bool load(std::istream &is) {
+        return read_binary(is, step_size) && read_engine(is, rng);
+    }
+
+private:
+    /**
+     * Advances coordinate x by a step with momentum p, reversing p at the
+     * walls of a closed box.
+     */
+    double drift(double x, double &p) const {
+        const auto y = x + step_size * p;
+        if (periodic) {
+            return minimum_image(y, box_length, 1.0 / box_length);
+        }
+        // Odd numbers of reflections reverse the momentum
+        const auto k =
+            static_cast<long>(std::floor((y + limit) / (2.0 * limit)));
+        if (k % 2 != 0) {
+            p = -p;
+        }
+        return reflect(y, limit);
+    }
+
+private:
+    double step_size;
+    std::size_t n_leapfrog;
+    double limit;
+    double box_length;
+    bool periodic;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> unif_real;
+
+    // Buffers of the trajectory
+    State trial;
+    std::vector<Force> momenta;
+    std::vector<Force> forces;
+};
+
+#endif // HYBRIDMONTECARLO_H_
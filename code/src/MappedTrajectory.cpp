@@ -0,0 +1,94 @@
+#include "MappedTrajectory.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedTrajectory::MappedTrajectory(const std::string &filename) {
+#ifdef _WIN32
+    auto file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    file_handle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return;
+    }
+    mapping_size = static_cast<std::size_t>(size.QuadPart);
+
+    mapping_handle =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle) {
+        return;
+    }
+    mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!mapping) {
+        return;
+    }
+#else
+    const auto fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return;
+    }
+    mapping_size = static_cast<std::size_t>(st.st_size);
+
+    auto addr = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after closing the descriptor
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return;
+    }
+    mapping = addr;
+#endif
+
+    const auto data = static_cast<const char *>(mapping);
+    if (mapping_size < sizeof(TrajectoryHeader)) {
+        return;
+    }
+    const auto h = reinterpret_cast<const TrajectoryHeader *>(data);
+    TrajectoryHeader check;
+    std::memcpy(&check, h, sizeof(check));
+    if (!valid_trajectory_header(check) ||
+        !trajectory_fits(check, mapping_size)) {
+        return;
+    }
+
+    header = h;
+    charge_data = reinterpret_cast<const double *>(data + sizeof(*h));
+    frame_data = data + frames_offset(*h);
+    n_frames = (mapping_size - frames_offset(*h)) / frame_bytes(*h);
+}
+
+MappedTrajectory::~MappedTrajectory() {
+#ifdef _WIN32
+    if (mapping) {
+        UnmapViewOfFile(mapping);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+#else
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+#endif
+}
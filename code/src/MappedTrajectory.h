@@ -0,0 +1,116 @@
+#ifndef MAPPEDTRAJECTORY_H_
+#define MAPPEDTRAJECTORY_H_
+
+#include <cstddef>
+#include <string>
+
+#include "ParticleTraits.h"
+#include "Trajectory.h"
+
+/**
+ * FrameView
+ *
+ * Zero-copy view of a single frame of a mapped trajectory: the coordinates
+ * of n_particles particles with dim values each, particle after particle.
+ */
+template <typename Float>
+struct FrameView {
+    const Float *data = nullptr;
+    std::size_t n_particles = 0;
+    std::size_t dim = 0;
+
+    /**
+     * Whether the view refers to a frame.
+     */
+    explicit operator bool() const { return data != nullptr; }
+
+    /**
+     * Coordinates of particle i.
+     */
+    const Float *particle(std::size_t i) const { return data + i * dim; }
+
+    Float coordinate(std::size_t i, std::size_t d) const {
+        return data[i * dim + d];
+    }
+};
+
+/**
+ * MappedTrajectory
+ *
+ * Memory-maps a binary trajectory file (see Trajectory.h) and gives O(1)
+ * random access to its frames without reading or copying them.
+ */
+class MappedTrajectory {
+public:
+    /**
+     * Maps a trajectory file. Check good() for success.
+     */
+    explicit MappedTrajectory(const std::string &filename);
+
+    MappedTrajectory(const MappedTrajectory &) = delete;
+    MappedTrajectory &operator=(const MappedTrajectory &) = delete;
+
+    ~MappedTrajectory();
+
+    /**
+     * Whether the file was mapped and contains a valid trajectory.
+     */
+    bool good() const { return header != nullptr; }
+
+    const TrajectoryHeader &get_header() const { return *header; }
+
+    /**
+     * Number of frames.
+     */
+    std::size_t size() const { return n_frames; }
+
+    /**
+     * Charges of the particles.
+     */
+    const double *charges() const { return charge_data; }
+
+    /**
+     * View of frame i. Float has to match the stored precision, otherwise
+     * an empty view is returned.
+     */
+    template <typename Float>
+    FrameView<Float> frame(std::size_t i) const {
+        FrameView<Float> ret;
+        if (good() && sizeof(Float) == header->precision && i < n_frames) {
+            ret.data = reinterpret_cast<const Float *>(
+                frame_data + i * frame_bytes(*header));
+            ret.n_particles = header->n_particles;
+            ret.dim = header->dim;
+        }
+        return ret;
+    }
+
+    /**
+     * Materializes particle k of frame i, for either precision.
+     */
+    template <typename ParticleState>
+    ParticleState particle(std::size_t i, std::size_t k) const {
+        double x[ParticleTraits<ParticleState>::dim];
+        for (std::size_t d = 0; d < ParticleTraits<ParticleState>::dim; ++d) {
+            x[d] = header->precision == 4
+                       ? frame<float>(i).coordinate(k, d)
+                       : frame<double>(i).coordinate(k, d);
+        }
+        return ParticleTraits<ParticleState>::make(charge_data[k], x);
+    }
+
+private:
+    void *mapping = nullptr;
+    std::size_t mapping_size = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+    const TrajectoryHeader *header = nullptr;
+    const double *charge_data = nullptr;
+    const char *frame_data = nullptr;
+    std::size_t n_frames = 0;
+};
+
+#endif // MAPPEDTRAJECTORY_H_
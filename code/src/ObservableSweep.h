@@ -0,0 +1,525 @@
+#ifndef OBSERVABLESWEEP_H_
+#define OBSERVABLESWEEP_H_
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "BinaryIO.h"
+#include "Boundary.h"
+#include "CanonicalEnsemble.h"
+#include "Checkpoint.h"
+#include "HybridMonteCarlo.h"
+#include "Observables.h"
+#include "Random.h"
+#include "Statistics.h"
+#include "StepSizeTuner.h"
+#include "SweepScheduler.h"
+
+/**
+ * Observable sweeps
+ *
+ * Chains over a beta ladder measuring the average pair distance and the
+ * potential energy until the error bar of the observable drops below a
+ * tolerance, written to a CSV table. Every chain checkpoints itself
+ * periodically and the sweep keeps the betas already written in a
+ * checkpoint of its own, so that an interrupted sweep resumes where it
+ * stopped. The system only enters through the ensembles of the chains.
+ */
+
+/**
+ * Number of steps between two progress reports of a chain.
+ */
+const std::size_t segment_steps = 10000;
+
+/**
+ * Upper limit of the burn-in steps of a chain.
+ */
+const std::size_t max_burn_in_steps = 2000000;
+
+/**
+ * Minimum wall-clock time between two checkpoints of a chain.
+ */
+const std::chrono::seconds checkpoint_interval(300);
+
+/**
+ * Moves of a chain, the box they are confined to and whether trajectories
+ * of all particles are interleaved with the single particle steps.
+ */
+struct ChainSettings {
+    // Initial step size of the proposal, tuned during burn-in
+    double delta = 1.0;
+    double box_length = 15.0;
+    Boundary boundary = Boundary::hard;
+    // Hybrid Monte Carlo: single particle steps between two trajectories of
+    // all particles (zero disables them), leapfrog steps per trajectory and
+    // their initial step size
+    std::size_t hmc_interval = 0;
+    std::size_t hmc_length = 20;
+    double hmc_dt = 0.01;
+};
+
+/**
+ * Convergence criterion, threads and files of a sweep.
+ */
+struct SweepSettings {
+    // Target relative error of the observable and limits of the steps per
+    // beta, summed over all chains of a beta
+    double tolerance = 1e-3;
+    std::size_t min_steps = 100000;
+    std::size_t max_steps = 15000000;
+    // Chains per beta, zero is unlimited. A single chain makes the results
+    // depend on the master seed only.
+    std::size_t max_chains = 0;
+    // Number of sweeps, zero repeats them forever
+    std::size_t repeat = 1;
+    // Worker threads, zero uses all hardware threads
+    std::size_t threads = 0;
+    // Master seed of the first sweep, sweep i uses seed + i. Zero draws a
+    // random one for every sweep.
+    std::uint64_t seed = 0;
+    // Output file, empty selects the start time
+    std::string output;
+    // Prefix of the checkpoint files in the working directory, empty
+    // disables checkpoints
+    std::string checkpoint;
+    // Comment lines written to the table header. A sweep is only resumed
+    // if they are unchanged.
+    std::string description;
+};
+
+/**
+ * Side length of a periodic box, zero for a closed box.
+ */
+inline double periodic_length(const ChainSettings &settings) {
+    return settings.boundary == Boundary::periodic ? settings.box_length : 0.0;
+}
+
+/**
+ * Hybrid Monte Carlo moves of a chain, drawing from a stream derived from
+ * the seed of the chain.
+ */
+template <typename Ensemble>
+HybridMonteCarlo<Ensemble> make_hmc(const ChainSettings &settings,
+                                    const Seed &seed) {
+    return HybridMonteCarlo<Ensemble>(
+        settings.hmc_dt, settings.hmc_length, settings.box_length,
+        settings.boundary, Seed{stream_seed(seed), 0});
+}
+
+/**
+ * Whether a trajectory of all particles is due after the given number of
+ * single particle steps.
+ */
+inline bool hmc_due(const ChainSettings &settings, std::size_t steps) {
+    return settings.hmc_interval > 0 && steps % settings.hmc_interval == 0;
+}
+
+/**
+ * Executes a trajectory, see HybridMonteCarlo::step. Potentials without
+ * forces like the Ewald sum never execute one.
+ */
+template <typename Ensemble>
+bool hmc_step(HybridMonteCarlo<Ensemble> &hmc, Ensemble &ensemble,
+              std::true_type) {
+    return hmc.step(ensemble);
+}
+
+template <typename Ensemble>
+bool hmc_step(HybridMonteCarlo<Ensemble> &, Ensemble &, std::false_type) {
+    return false;
+}
+
+/**
+ * Whether the potential of the ensemble provides forces.
+ */
+template <typename Ensemble>
+using EnsembleHasForce = HasForce<typename Ensemble::PotentialFunction,
+                                  typename Ensemble::State::value_type>;
+
+/**
+ * Output file name: the given one or the start time with the suffix.
+ */
+inline std::string output_name(const std::string &output,
+                               const std::string &suffix) {
+    if (!output.empty()) {
+        return output;
+    }
+    const auto time = std::time(nullptr);
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&time), "%Y_%m_%d_%H_%M_%S");
+    ss << suffix;
+    return ss.str();
+}
+
+/**
+ * Number of worker threads, zero selects all hardware threads.
+ */
+inline std::size_t n_threads(std::size_t threads) {
+    return threads > 0 ? threads : ThreadPool::default_size();
+}
+
+/**
+ * Writes a checkpoint, see write_checkpoint(). A chain or sweep that can no
+ * longer be checkpointed, e.g. on a full disk, is not continued without
+ * them: the program reports the file and aborts.
+ */
+inline void
+write_checkpoint_or_abort(const std::string &filename,
+                          const std::function<void(std::ostream &)> &write) {
+    if (!write_checkpoint(filename, write)) {
+        std::cerr << "Cannot write checkpoint " << filename << std::endl;
+        std::abort();
+    }
+}
+
+/**
+ * Cuts a file back to its first size bytes, dropping whatever was written
+ * after the last checkpoint.
+ * returns: false if the file is shorter or cannot be rewritten
+ */
+inline bool truncate_file(const std::string &filename, std::uint64_t size) {
+    std::ifstream is(filename, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(is)),
+                        std::istreambuf_iterator<char>());
+    if (!is.eof() || content.size() < size) {
+        return false;
+    }
+    if (content.size() == size) {
+        return true;
+    }
+    is.close();
+    std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+    os.write(content.data(), size);
+    os.flush();
+    return static_cast<bool>(os);
+}
+
+/**
+ * Calculates average pair distance and potential energy from samples of
+ * ensemble, whose proposal is confined to the box of settings. The
+ * statistics are reported to progress every segment_steps steps until it
+ * returns false. The chain is checkpointed periodically to the given file,
+ * if any, and resumes from it if it was written for the same seed.
+ * returns: statistics of the chain
+ */
+template <typename Ensemble>
+ChainStatistics
+calc_obs(Ensemble &ensemble, const ChainSettings &settings, const Seed &seed,
+         const std::string &checkpoint,
+         const SweepScheduler<ChainStatistics>::Progress &progress) {
+    using ParticleState = typename Ensemble::State::value_type;
+
+    ensemble.enable_energy_cache();
+
+    ChainStatistics stats;
+    EquilibrationDetector equilibration;
+    StepSizeTuner tuner(settings.delta, settings.box_length);
+    AvgPairDistance<ParticleState> pair_dist(ensemble.get_state(),
+                                             periodic_length(settings));
+    auto stage = ChainStage::burn_in;
+
+    // Trajectories of all particles interleaved with the steps, whose step
+    // size is tuned to the 65% acceptance at which they are most efficient
+    const auto hmc_enabled = settings.hmc_interval > 0;
+    auto hmc = make_hmc<Ensemble>(settings, seed);
+    const StepSizeTuner initial_hmc_tuner(settings.hmc_dt,
+                                          settings.box_length, 0.65, 20);
+    auto hmc_tuner = initial_hmc_tuner;
+    const EnsembleHasForce<Ensemble> has_force{};
+
+    // The checkpoint holds everything the remaining steps depend on, a chain
+    // resumed from it continues where it stopped
+    auto save = [&] {
+        if (checkpoint.empty()) {
+            return;
+        }
+        write_checkpoint_or_abort(checkpoint, [&](std::ostream &os) {
+            write_binary(os, seed);
+            write_binary(os, stage);
+            ensemble.save(os);
+            equilibration.save(os);
+            tuner.save(os);
+            pair_dist.save(os);
+            stats.save(os);
+            if (hmc_enabled) {
+                hmc.save(os);
+                hmc_tuner.save(os);
+            }
+        });
+    };
+    const auto resumed =
+        !checkpoint.empty() &&
+        read_checkpoint(checkpoint, [&](std::istream &is) {
+            Seed saved_seed;
+            return read_binary(is, saved_seed) &&
+                   saved_seed.master == seed.master &&
+                   saved_seed.stream == seed.stream &&
+                   read_binary(is, stage) && ensemble.load(is) &&
+                   equilibration.load(is) && tuner.load(is) &&
+                   pair_dist.load(is) && stats.load(is) &&
+                   (!hmc_enabled || (hmc.load(is) && hmc_tuner.load(is)));
+        });
+    if (!resumed) {
+        // A checkpoint failing half-way leaves a valid configuration behind,
+        // from which the chain is burnt in afresh
+        stage = ChainStage::burn_in;
+        stats = ChainStatistics();
+        equilibration = EquilibrationDetector();
+        tuner = StepSizeTuner(settings.delta, settings.box_length);
+        hmc_tuner = initial_hmc_tuner;
+        hmc.set_step_size(settings.hmc_dt);
+    }
+    if (stage == ChainStage::finished) {
+        return stats;
+    }
+
+    auto last_save = std::chrono::steady_clock::now();
+    auto save_if_due = [&] {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_save >= checkpoint_interval) {
+            save();
+            last_save = now;
+        }
+    };
+
+    // Burn-in until the energy series is equilibrated, meanwhile the step
+    // sizes are tuned and frozen afterwards
+    if (stage == ChainStage::burn_in) {
+        ensemble.get_proposal().set_delta(tuner.get_delta());
+        while (!equilibration.equilibrated() &&
+               equilibration.count() < max_burn_in_steps) {
+            if (tuner.add(ensemble.step())) {
+                ensemble.get_proposal().set_delta(tuner.get_delta());
+            }
+            if (hmc_due(settings, equilibration.count() + 1) &&
+                hmc_tuner.add(hmc_step(hmc, ensemble, has_force))) {
+                hmc.set_step_size(hmc_tuner.get_delta());
+            }
+            equilibration.add(ensemble.energy());
+            if (equilibration.count() % segment_steps == 0) {
+                save_if_due();
+            }
+        }
+        stats.burn_in = equilibration.count();
+        stats.delta = ensemble.get_proposal().get_delta();
+        // Refresh the energy cache, the random initial state may contain
+        // nearly overlapping particles whose huge energies spoil the cached
+        // sums
+        ensemble.enable_energy_cache();
+        pair_dist.reset(ensemble.get_state());
+        stage = ChainStage::measurement;
+    }
+    ensemble.get_proposal().set_delta(stats.delta);
+
+    // The pair distance is updated with every accepted move, which makes it
+    // cheap enough to be measured after every step
+    ensemble.add_move_observer([&pair_dist](
+                                   const typename Ensemble::State &state,
+                                   std::size_t ix,
+                                   const ParticleState &old_pos) {
+        pair_dist.update(state, ix, old_pos);
+    });
+
+    // Calculation of the expectation value
+    do {
+        for (std::size_t i = 0; i < segment_steps; ++i) {
+            if (ensemble.step()) {
+                ++stats.accepted;
+            }
+            if (hmc_due(settings, stats.steps + i + 1)) {
+                hmc_step(hmc, ensemble, has_force);
+            }
+            stats.observable.add(pair_dist.value());
+            stats.energy.add(ensemble.energy());
+        }
+        stats.steps += segment_steps;
+        save_if_due();
+    } while (progress(stats));
+
+    // A finished chain is kept until its beta is written, a resumed sweep
+    // takes over its statistics
+    stage = ChainStage::finished;
+    save();
+    return stats;
+}
+
+/**
+ * Runs chains over the ladder betas until the error bar of the observable
+ * drops below the tolerance and writes the results to a CSV table in
+ * completion order. The ensemble of a chain is created by
+ * make_ensemble(beta, seed) with its initial state drawn from the stream
+ * seed, see calc_obs() for the chain. An interrupted sweep is resumed from
+ * its checkpoints if the betas and the description are unchanged.
+ * returns: exit code, non-zero if the table could not be written
+ */
+template <typename MakeEnsemble>
+int run_observable_sweep(const std::vector<double> &betas,
+                         const SweepSettings &sweep,
+                         const ChainSettings &chain,
+                         const MakeEnsemble &make_ensemble) {
+    SweepScheduler<ChainStatistics> scheduler(n_threads(sweep.threads));
+    scheduler.set_max_chains(sweep.max_chains);
+
+    const auto use_checkpoints = !sweep.checkpoint.empty();
+    const auto sweep_checkpoint = sweep.checkpoint + ".sweep.ckpt";
+    auto chain_checkpoint = [&](std::size_t index, std::size_t repetition) {
+        if (!use_checkpoints) {
+            return std::string();
+        }
+        return sweep.checkpoint + ".chain_" + std::to_string(index) + "_" +
+               std::to_string(repetition) + ".ckpt";
+    };
+
+    for (std::size_t i = 0; sweep.repeat == 0 || i < sweep.repeat; ++i) {
+        // Timing
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        // Progress of the sweep: description, master seed, output file, its
+        // length and the betas written up to there
+        std::string description;
+        std::uint64_t master_seed = 0;
+        std::string filename;
+        std::uint64_t written = 0;
+        std::vector<std::uint8_t> finished;
+        auto save_sweep = [&] {
+            if (!use_checkpoints) {
+                return;
+            }
+            write_checkpoint_or_abort(sweep_checkpoint, [&](std::ostream &os) {
+                write_binary(os, sweep.description);
+                write_binary(os, master_seed);
+                write_binary(os, filename);
+                write_binary(os, written);
+                write_binary(os, finished);
+            });
+        };
+        // A row written after the last checkpoint belongs to a beta that is
+        // still unfinished in it, and is cut off before it is run again
+        const auto resumed =
+            use_checkpoints &&
+            read_checkpoint(sweep_checkpoint, [&](std::istream &is) {
+                return read_binary(is, description) &&
+                       description == sweep.description &&
+                       read_binary(is, master_seed) &&
+                       read_binary(is, filename) &&
+                       read_binary(is, written) &&
+                       read_binary(is, finished) &&
+                       finished.size() == betas.size();
+            }) &&
+            truncate_file(filename, written);
+
+        std::ofstream os;
+        std::vector<SweepScheduler<ChainStatistics>::BetaProgress> resume;
+        if (resumed) {
+            // Continue the interrupted sweep, every chain with a checkpoint
+            // is restarted
+            os.open(filename, std::ios::app | std::ios::binary);
+            resume.resize(betas.size());
+            for (std::size_t b = 0; b < betas.size(); ++b) {
+                resume[b].finished = finished[b] != 0;
+                while (checkpoint_exists(
+                    chain_checkpoint(b, resume[b].chains))) {
+                    ++resume[b].chains;
+                }
+            }
+        } else {
+            const auto time = std::time(nullptr);
+            filename = output_name(sweep.output, ".csv");
+            master_seed =
+                sweep.seed != 0 ? sweep.seed + i : random_seed().master;
+            finished.assign(betas.size(), 0);
+
+            os.open(filename, std::ios::binary);
+
+            // Table header
+            os << "# Start of simulation: " << std::ctime(&time);
+            os << "# Master seed: " << master_seed << "\n";
+            os << sweep.description;
+            os << "beta,acc,obs,obs_err,obs_tau,energy,energy_err,chains,"
+                  "steps,burn_in,delta\n"
+               << std::flush;
+            written = static_cast<std::uint64_t>(os.tellp());
+            save_sweep();
+        }
+        if (!os) {
+            std::cerr << "Cannot open " << filename << std::endl;
+            return 1;
+        }
+
+        // The chains use the streams given by the position of beta in the
+        // ladder and the repetition
+        scheduler.run_converging(
+            betas,
+            [&](const JobKey &key,
+                const SweepScheduler<ChainStatistics>::Progress &progress) {
+                const Seed seed{master_seed,
+                                (std::uint64_t(key.index) << 32) |
+                                    key.repetition};
+                auto ensemble = make_ensemble(key.beta, seed);
+                return calc_obs(ensemble, chain, seed,
+                                chain_checkpoint(key.index, key.repetition),
+                                progress);
+            },
+            [](ChainStatistics &stats, const ChainStatistics &other) {
+                stats.merge(other);
+            },
+            [&](const ChainStatistics &stats) {
+                const auto &obs = stats.observable;
+                return stats.steps >= sweep.max_steps ||
+                       (stats.steps >= sweep.min_steps &&
+                        obs.error() < sweep.tolerance * std::abs(obs.mean()));
+            },
+            [&](const JobKey &key, const ChainStatistics &stats) {
+                const auto avg_pair_d = stats.observable.estimate();
+                const auto energy = stats.energy.estimate();
+                os << key.beta << "," << stats.acceptance() << ","
+                   << avg_pair_d.mean << "," << avg_pair_d.error << ","
+                   << avg_pair_d.tau << "," << energy.mean << ","
+                   << energy.error << "," << stats.chains << ","
+                   << stats.steps << "," << stats.burn_in << ","
+                   << stats.delta << "\n"
+                   << std::flush;
+                if (!os) {
+                    std::cerr << "Cannot write " << filename << std::endl;
+                    std::abort();
+                }
+
+                // The chains of a written beta are no longer needed
+                finished[key.index] = 1;
+                written = static_cast<std::uint64_t>(os.tellp());
+                save_sweep();
+                for (std::size_t r = 0; use_checkpoints && r < stats.chains;
+                     ++r) {
+                    remove_checkpoint(chain_checkpoint(key.index, r));
+                }
+            },
+            resume);
+        if (use_checkpoints) {
+            remove_checkpoint(sweep_checkpoint);
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::minutes>(end - start);
+        std::cout << filename << ": " << elapsed.count() << " min"
+                  << std::endl;
+    }
+    return 0;
+}
+
+#endif // OBSERVABLESWEEP_H_
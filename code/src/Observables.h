@@ -0,0 +1,105 @@
+#ifndef OBSERVABLES_H_
+#define OBSERVABLES_H_
+
+#include <cmath>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "BinaryIO.h"
+#include "ParticleTraits.h"
+
+/**
+ * AvgPairDistance
+ *
+ * Average distance of all particle pairs, maintained incrementally: an
+ * accepted single particle move only changes the distances of the moved
+ * particle, so the running sum is updated in O(N) instead of recomputing all
+ * N(N-1)/2 pairs. Register update() as move observer of the ensemble. In a
+ * periodic box distances follow the minimum image convention.
+ */
+template <typename ParticleState>
+class AvgPairDistance {
+public:
+    using State = std::vector<ParticleState>;
+
+public:
+    AvgPairDistance() = default;
+
+    /**
+     * Constructor taking the state and the side length of a periodic box,
+     * zero for an open box.
+     */
+    explicit AvgPairDistance(const State &state, double box_length = 0.0)
+        : box_length(box_length) {
+        reset(state);
+    }
+
+    /**
+     * Recomputes the sum of all pair distances, which also discards
+     * accumulated round-off.
+     */
+    void reset(const State &state) {
+        n = state.size();
+        sum = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = 0; j < i; ++j) {
+                sum += distance(state[i], state[j]);
+            }
+        }
+    }
+
+    /**
+     * Updates the sum after particle ix moved from old_pos to its position in
+     * state.
+     */
+    void update(const State &state, std::size_t ix,
+                const ParticleState &old_pos) {
+        const auto &new_pos = state[ix];
+        for (std::size_t j = 0; j < n; ++j) {
+            if (j != ix) {
+                sum += distance(state[j], new_pos) -
+                       distance(state[j], old_pos);
+            }
+        }
+    }
+
+    /**
+     * Average pair distance.
+     */
+    double value() const {
+        return 2.0 / static_cast<double>(n * (n - 1)) * sum;
+    }
+
+    /**
+     * Writes the running sum for a checkpoint. Restoring it instead of
+     * calling reset() keeps the accumulated round-off, so that a resumed
+     * chain measures the same values.
+     */
+    void save(std::ostream &os) const {
+        write_binary(os, n);
+        write_binary(os, sum);
+    }
+
+    /**
+     * Restores the running sum written by save().
+     * returns: false if the stream does not hold it
+     */
+    bool load(std::istream &is) {
+        return read_binary(is, n) && read_binary(is, sum);
+    }
+
+private:
+    double distance(const ParticleState &a, const ParticleState &b) const {
+        return std::sqrt(box_length > 0.0 ? distance_sq(a, b, box_length)
+                                          : distance_sq(a, b));
+    }
+
+private:
+    double box_length = 0.0;
+    std::size_t n = 0;
+    double sum = 0.0;
+};
+
+#endif // OBSERVABLES_H_
@@ -0,0 +1,305 @@
+#include "PairKernels.h"
+
+#include <atomic>
+
+#include "Boundary.h"
+#include "PotentialKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIAP_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * Pair energies as a function of the squared distance and the product of the
+ * charges. Every operation provides a scalar, an AVX2 and an AVX-512 version.
+ */
+struct CoulombCoreOp {
+    static double scalar(double d2, double qq) {
+        return coulomb_core_kernel(d2, qq);
+    }
+
+#ifdef PIAP_X86_SIMD
+    __attribute__((target("avx2,fma"))) static __m256d avx2(__m256d d2,
+                                                            __m256d qq) {
+        const auto inv_r2 = _mm256_div_pd(_mm256_set1_pd(1.0), d2);
+        const auto inv_r4 = _mm256_mul_pd(inv_r2, inv_r2);
+        return _mm256_fmadd_pd(qq, _mm256_sqrt_pd(inv_r2),
+                               _mm256_mul_pd(inv_r4, inv_r4));
+    }
+
+    __attribute__((target("avx512f"))) static __m512d avx512(__m512d d2,
+                                                             __m512d qq) {
+        const auto inv_r2 = _mm512_div_pd(_mm512_set1_pd(1.0), d2);
+        const auto inv_r4 = _mm512_mul_pd(inv_r2, inv_r2);
+        // The unmasked intrinsic passes _mm512_undefined_pd() as source,
+        // which GCC 12 reports as maybe-uninitialized
+        const auto inv_r = _mm512_mask_sqrt_pd(inv_r2, 0xFF, inv_r2);
+        return _mm512_fmadd_pd(qq, inv_r, _mm512_mul_pd(inv_r4, inv_r4));
+    }
+#endif
+};
+
+struct LennardJonesOp {
+    static double scalar(double d2, double) { return lennard_jones_kernel(d2); }
+
+#ifdef PIAP_X86_SIMD
+    __attribute__((target("avx2,fma"))) static __m256d avx2(__m256d d2,
+                                                            __m256d) {
+        const auto inv_r2 = _mm256_div_pd(_mm256_set1_pd(1.0), d2);
+        const auto inv_r6 =
+            _mm256_mul_pd(_mm256_mul_pd(inv_r2, inv_r2), inv_r2);
+        return _mm256_fmsub_pd(inv_r6, inv_r6, inv_r6);
+    }
+
+    __attribute__((target("avx512f"))) static __m512d avx512(__m512d d2,
+                                                             __m512d) {
+        const auto inv_r2 = _mm512_div_pd(_mm512_set1_pd(1.0), d2);
+        const auto inv_r6 =
+            _mm512_mul_pd(_mm512_mul_pd(inv_r2, inv_r2), inv_r2);
+        return _mm512_fmsub_pd(inv_r6, inv_r6, inv_r6);
+    }
+#endif
+};
+
+template <typename Op, bool Periodic, std::size_t Dim>
+double row_scalar(const SoAState<Dim> &state, const std::array<double, Dim> &p,
+                  double q, std::size_t ix, double *out, double box_length) {
+    const auto inv_box_length = Periodic ? 1.0 / box_length : 0.0;
+    const auto n = state.size();
+    const auto charge = state.charge();
+    auto sum = 0.0;
+    for (std::size_t j = 0; j < state.padded_size(); ++j) {
+        if (j == ix || j >= n) {
+            out[j] = 0.0;
+            continue;
+        }
+        auto d2 = 0.0;
+        for (std::size_t d = 0; d < Dim; ++d) {
+            auto diff = state.coordinate(d)[j] - p[d];
+            if (Periodic) {
+                diff = minimum_image(diff, box_length, inv_box_length);
+            }
+            d2 += diff * diff;
+        }
+        out[j] = Op::scalar(d2, q * charge[j]);
+        sum += out[j];
+    }
+    return sum;
+}
+
+#ifdef PIAP_X86_SIMD
+template <typename Op, bool Periodic, std::size_t Dim>
+__attribute__((target("avx2,fma"))) double
+row_avx2(const SoAState<Dim> &state, const std::array<double, Dim> &p,
+         double q, std::size_t ix, double *out, double box_length) {
+    const auto box = _mm256_set1_pd(box_length);
+    const auto inv_box = _mm256_set1_pd(Periodic ? 1.0 / box_length : 0.0);
+    __m256d pv[Dim];
+    for (std::size_t d = 0; d < Dim; ++d) {
+        pv[d] = _mm256_set1_pd(p[d]);
+    }
+    const auto qv = _mm256_set1_pd(q);
+    const auto one = _mm256_set1_pd(1.0);
+    const auto ixv = _mm256_set1_pd(static_cast<double>(ix));
+    const auto nv = _mm256_set1_pd(static_cast<double>(state.size()));
+    const auto lane_step = _mm256_set1_pd(4.0);
+    const auto charge = state.charge();
+
+    auto jv = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+    auto acc = _mm256_setzero_pd();
+    for (std::size_t j = 0; j < state.padded_size(); j += 4) {
+        auto d2 = _mm256_setzero_pd();
+        for (std::size_t d = 0; d < Dim; ++d) {
+            auto diff =
+                _mm256_sub_pd(_mm256_load_pd(state.coordinate(d) + j), pv[d]);
+            if (Periodic) {
+                const auto images = _mm256_round_pd(
+                    _mm256_mul_pd(diff, inv_box),
+                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                diff = _mm256_fnmadd_pd(images, box, diff);
+            }
+            d2 = _mm256_fmadd_pd(diff, diff, d2);
+        }
+        // Mask out the particle itself and the padding
+        const auto mask = _mm256_and_pd(_mm256_cmp_pd(jv, ixv, _CMP_NEQ_OQ),
+                                        _mm256_cmp_pd(jv, nv, _CMP_LT_OQ));
+        d2 = _mm256_blendv_pd(one, d2, mask);
+
+        const auto qq = _mm256_mul_pd(qv, _mm256_load_pd(charge + j));
+        const auto e = _mm256_and_pd(Op::avx2(d2, qq), mask);
+        _mm256_store_pd(out + j, e);
+        acc = _mm256_add_pd(acc, e);
+        jv = _mm256_add_pd(jv, lane_step);
+    }
+    const auto lo = _mm256_castpd256_pd128(acc);
+    const auto hi = _mm256_extractf128_pd(acc, 1);
+    const auto sum2 = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(sum2, _mm_unpackhi_pd(sum2, sum2)));
+}
+
+template <typename Op, bool Periodic, std::size_t Dim>
+__attribute__((target("avx512f"))) double
+row_avx512(const SoAState<Dim> &state, const std::array<double, Dim> &p,
+           double q, std::size_t ix, double *out, double box_length) {
+    const auto box = _mm512_set1_pd(box_length);
+    const auto inv_box = _mm512_set1_pd(Periodic ? 1.0 / box_length : 0.0);
+    __m512d pv[Dim];
+    for (std::size_t d = 0; d < Dim; ++d) {
+        pv[d] = _mm512_set1_pd(p[d]);
+    }
+    const auto qv = _mm512_set1_pd(q);
+    const auto one = _mm512_set1_pd(1.0);
+    const auto ixv = _mm512_set1_pd(static_cast<double>(ix));
+    const auto nv = _mm512_set1_pd(static_cast<double>(state.size()));
+    const auto lane_step = _mm512_set1_pd(8.0);
+    const auto charge = state.charge();
+
+    auto jv = _mm512_setr_pd(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+    auto acc = _mm512_setzero_pd();
+    for (std::size_t j = 0; j < state.padded_size(); j += 8) {
+        auto d2 = _mm512_setzero_pd();
+        for (std::size_t d = 0; d < Dim; ++d) {
+            auto diff =
+                _mm512_sub_pd(_mm512_load_pd(state.coordinate(d) + j), pv[d]);
+            if (Periodic) {
+                // Masked form with a defined source, see CoulombCoreOp
+                const auto scaled = _mm512_mul_pd(diff, inv_box);
+                const auto images = _mm512_mask_roundscale_pd(
+                    scaled, 0xFF, scaled,
+                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                diff = _mm512_fnmadd_pd(images, box, diff);
+            }
+            d2 = _mm512_fmadd_pd(diff, diff, d2);
+        }
+        // Mask out the particle itself and the padding
+        const auto mask = _mm512_cmp_pd_mask(jv, ixv, _CMP_NEQ_OQ) &
+                          _mm512_cmp_pd_mask(jv, nv, _CMP_LT_OQ);
+        d2 = _mm512_mask_blend_pd(mask, one, d2);
+
+        const auto qq = _mm512_mul_pd(qv, _mm512_load_pd(charge + j));
+        const auto e = _mm512_maskz_mov_pd(mask, Op::avx512(d2, qq));
+        _mm512_store_pd(out + j, e);
+        acc = _mm512_add_pd(acc, e);
+        jv = _mm512_add_pd(jv, lane_step);
+    }
+    // _mm512_reduce_add_pd() extracts through undefined sources as well
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, acc);
+    auto sum = 0.0;
+    for (const auto lane : lanes) {
+        sum += lane;
+    }
+    return sum;
+}
+#endif
+
+std::atomic<int> current_level(static_cast<int>(detect_simd_level()));
+
+template <typename Op, bool Periodic, std::size_t Dim>
+double row_level(const SoAState<Dim> &state, const std::array<double, Dim> &p,
+                 double q, std::size_t ix, double *out, double box_length) {
+    switch (static_cast<SimdLevel>(
+        current_level.load(std::memory_order_relaxed))) {
+#ifdef PIAP_X86_SIMD
+    case SimdLevel::avx512:
+        return row_avx512<Op, Periodic>(state, p, q, ix, out, box_length);
+    case SimdLevel::avx2:
+        return row_avx2<Op, Periodic>(state, p, q, ix, out, box_length);
+#endif
+    default:
+        return row_scalar<Op, Periodic>(state, p, q, ix, out, box_length);
+    }
+}
+
+/**
+ * Selects the kernel without minimum image wrapping for open boxes.
+ */
+template <typename Op, std::size_t Dim>
+double row(const SoAState<Dim> &state, const std::array<double, Dim> &p,
+           double q, std::size_t ix, double *out, double box_length) {
+    return box_length > 0.0
+               ? row_level<Op, true>(state, p, q, ix, out, box_length)
+               : row_level<Op, false>(state, p, q, ix, out, box_length);
+}
+
+} // namespace
+
+SimdLevel detect_simd_level() {
+#ifdef PIAP_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::avx2;
+    }
+#endif
+    return SimdLevel::scalar;
+}
+
+SimdLevel simd_level() {
+    return static_cast<SimdLevel>(current_level.load());
+}
+
+SimdLevel set_simd_level(SimdLevel level) {
+    const auto supported = detect_simd_level();
+    if (static_cast<int>(level) > static_cast<int>(supported)) {
+        level = supported;
+    }
+    current_level.store(static_cast<int>(level));
+    return level;
+}
+
+const char *to_string(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::avx512:
+        return "avx512";
+    case SimdLevel::avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+template <std::size_t Dim>
+double coulomb_core_row(const SoAState<Dim> &state,
+                        const std::array<double, Dim> &p, double q,
+                        std::size_t ix, double *out, double box_length) {
+    return row<CoulombCoreOp>(state, p, q, ix, out, box_length);
+}
+
+template <std::size_t Dim>
+double lennard_jones_row(const SoAState<Dim> &state,
+                         const std::array<double, Dim> &p, double q,
+                         std::size_t ix, double *out, double box_length) {
+    return row<LennardJonesOp>(state, p, q, ix, out, box_length);
+}
+
+// Dimensions of Particle<D> supported by the row kernels
+template double coulomb_core_row<1>(const SoAState<1> &,
+                                    const std::array<double, 1> &, double,
+                                    std::size_t, double *, double);
+template double coulomb_core_row<2>(const SoAState<2> &,
+                                    const std::array<double, 2> &, double,
+                                    std::size_t, double *, double);
+template double coulomb_core_row<3>(const SoAState<3> &,
+                                    const std::array<double, 3> &, double,
+                                    std::size_t, double *, double);
+template double coulomb_core_row<4>(const SoAState<4> &,
+                                    const std::array<double, 4> &, double,
+                                    std::size_t, double *, double);
+template double lennard_jones_row<1>(const SoAState<1> &,
+                                     const std::array<double, 1> &, double,
+                                     std::size_t, double *, double);
+template double lennard_jones_row<2>(const SoAState<2> &,
+                                     const std::array<double, 2> &, double,
+                                     std::size_t, double *, double);
+template double lennard_jones_row<3>(const SoAState<3> &,
+                                     const std::array<double, 3> &, double,
+                                     std::size_t, double *, double);
+template double lennard_jones_row<4>(const SoAState<4> &,
+                                     const std::array<double, 4> &, double,
+                                     std::size_t, double *, double);
@@ -0,0 +1,62 @@
+#ifndef PAIRKERNELS_H_
+#define PAIRKERNELS_H_
+
+#include <array>
+#include <cstddef>
+
+#include "SoAState.h"
+
+/**
+ * Instruction set used by the pair kernels.
+ */
+enum class SimdLevel { scalar, avx2, avx512 };
+
+/**
+ * Returns the widest instruction set supported by the CPU.
+ */
+SimdLevel detect_simd_level();
+
+/**
+ * Returns the instruction set currently used by the pair kernels. Defaults to
+ * detect_simd_level().
+ */
+SimdLevel simd_level();
+
+/**
+ * Selects the instruction set used by the pair kernels, e.g. to validate the
+ * vectorized kernels against the scalar fallback. Levels not supported by the
+ * CPU are lowered to the best supported one. Returns the selected level.
+ */
+SimdLevel set_simd_level(SimdLevel level);
+
+/**
+ * Name of an instruction set.
+ */
+const char *to_string(SimdLevel level);
+
+/**
+ * Energy row of coulomb_core: interaction of a particle with charge q at
+ * position p with all particles of the state except ix. The pair energies are
+ * written to out, which has to hold state.padded_size() doubles, masked
+ * entries are zero. A positive box_length selects periodic boundaries with
+ * minimum image distances.
+ *
+ * Instantiated for 1 to 4 dimensions.
+ *
+ * returns: double - sum of the pair energies.
+ */
+template <std::size_t Dim>
+double coulomb_core_row(const SoAState<Dim> &state,
+                        const std::array<double, Dim> &p, double q,
+                        std::size_t ix, double *out, double box_length = 0.0);
+
+/**
+ * Energy row of lennard_jones, see coulomb_core_row.
+ */
+template <std::size_t Dim>
+double lennard_jones_row(const SoAState<Dim> &state,
+                         const std::array<double, Dim> &p, double q,
+                         std::size_t ix, double *out,
+                         double box_length = 0.0);
+
+#endif // PAIRKERNELS_H_
@@ -0,0 +1,188 @@
+#ifndef PARALLELTEMPERING_H_
+#define PARALLELTEMPERING_H_
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Random.h"
+#include "ThreadPool.h"
+
+/**
+ * ParallelTempering
+ *
+ * Replica exchange across a ladder of betas. Every round, all replicas
+ * execute a number of Metropolis steps concurrently on a thread pool, after
+ * which neighbouring replicas swap their configurations with probability
+ * min(1, exp((beta_i - beta_j) * (E_i - E_j))). Even and odd pairs alternate
+ * between rounds.
+ */
+template <typename Ensemble>
+class ParallelTempering {
+public:
+    using State = typename Ensemble::State;
+
+    /**
+     * Observable measured on the state of every replica after each round.
+     */
+    using Observable = std::function<double(const State &)>;
+
+    /**
+     * Statistics of a single beta of the ladder.
+     */
+    struct Result {
+        double beta;
+        double acceptance;
+        double observable;
+        double energy;
+        // Rate of accepted swaps with the next higher beta
+        double swap_rate;
+    };
+
+public:
+    /**
+     * Constructor taking the replicas ordered by increasing beta, the number
+     * of Metropolis steps per replica between two exchanges, the number of
+     * threads and the seed of the exchange decisions. Enables the energy cache
+     * of every replica. With seeded replicas, the run is reproducible
+     * independently of the number of threads.
+     */
+    ParallelTempering(std::vector<Ensemble> replicas,
+                      std::size_t steps_per_round,
+                      std::size_t n_threads = ThreadPool::default_size(),
+                      const Seed &seed = random_seed())
+        : replicas(std::move(replicas)), steps_per_round(steps_per_round),
+          pool(n_threads), rng(make_rng<std::mt19937>(seed)) {
+        for (auto &replica : this->replicas) {
+            replica.enable_energy_cache();
+        }
+        reset();
+    }
+
+    /**
+     * Executes rounds without measuring. Replicas are still exchanged.
+     */
+    void burn_in(std::size_t n_rounds) {
+        for (std::size_t i = 0; i < n_rounds; ++i) {
+            round(nullptr);
+        }
+        for (auto &replica : replicas) {
+            // Discard the round-off of the equilibration
+            replica.enable_energy_cache();
+        }
+        reset();
+    }
+
+    /**
+     * Executes rounds and measures the observable and the energy of every
+     * replica after each of them.
+     */
+    void run(std::size_t n_rounds, const Observable &observable) {
+        for (std::size_t i = 0; i < n_rounds; ++i) {
+            round(&observable);
+        }
+    }
+
+    /**
+     * Per-beta statistics of the measurement rounds.
+     */
+    std::vector<Result> results() const {
+        std::vector<Result> ret;
+        for (std::size_t i = 0; i < replicas.size(); ++i) {
+            Result result;
+            result.beta = replicas[i].get_beta();
+            result.acceptance =
+                static_cast<double>(accepted_cnt[i]) /
+                (static_cast<double>(measured_rounds) * steps_per_round);
+            result.observable = obs_sum[i] / measured_rounds;
+            result.energy = energy_sum[i] / measured_rounds;
+            result.swap_rate =
+                swap_attempts[i] > 0
+                    ? static_cast<double>(swap_accepted[i]) / swap_attempts[i]
+                    : 0.0;
+            ret.push_back(result);
+        }
+        return ret;
+    }
+
+    const std::vector<Ensemble> &get_replicas() const { return replicas; }
+
+private:
+    /**
+     * Steps all replicas in parallel, measures if an observable is given, and
+     * exchanges neighbouring configurations.
+     */
+    void round(const Observable *observable) {
+        std::vector<std::future<void>> futures;
+        for (std::size_t i = 0; i < replicas.size(); ++i) {
+            futures.push_back(pool.submit([this, i, observable] {
+                auto &replica = replicas[i];
+                std::size_t accepted = 0;
+                for (std::size_t k = 0; k < steps_per_round; ++k) {
+                    if (replica.step()) {
+                        ++accepted;
+                    }
+                }
+                accepted_cnt[i] += accepted;
+                if (observable) {
+                    obs_sum[i] += (*observable)(replica.get_state());
+                    energy_sum[i] += replica.energy();
+                }
+            }));
+        }
+        for (auto &future : futures) {
+            future.get();
+        }
+        if (observable) {
+            ++measured_rounds;
+        }
+        exchange();
+    }
+
+    void exchange() {
+        for (auto i = parity; i + 1 < replicas.size(); i += 2) {
+            auto &a = replicas[i];
+            auto &b = replicas[i + 1];
+            const auto log_prob = (a.get_beta() - b.get_beta()) *
+                                  (a.energy() - b.energy());
+            ++swap_attempts[i];
+            if (log_prob >= 0.0 || unif_real(rng) < std::exp(log_prob)) {
+                a.swap_configuration(b);
+                ++swap_accepted[i];
+            }
+        }
+        parity = 1 - parity;
+    }
+
+    void reset() {
+        measured_rounds = 0;
+        accepted_cnt.assign(replicas.size(), 0);
+        obs_sum.assign(replicas.size(), 0.0);
+        energy_sum.assign(replicas.size(), 0.0);
+        swap_attempts.assign(replicas.size(), 0);
+        swap_accepted.assign(replicas.size(), 0);
+    }
+
+private:
+    std::vector<Ensemble> replicas;
+    std::size_t steps_per_round;
+
+    ThreadPool pool;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> unif_real;
+    std::size_t parity = 0;
+
+    std::size_t measured_rounds = 0;
+    std::vector<std::size_t> accepted_cnt;
+    std::vector<double> obs_sum;
+    std::vector<double> energy_sum;
+    std::vector<std::size_t> swap_attempts;
+    std::vector<std::size_t> swap_accepted;
+};
+
+#endif // PARALLELTEMPERING_H_
@@ -1,31 +1,212 @@
 #ifndef PARTICLE_H_
 #define PARTICLE_H_
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
 #include "CanonicalEnsemble.h"
+#include "PairKernels.h"
+#include "PotentialKernels.h"
+
+/**
+ * Charged particle in D dimensions. Every dimension dependent function is
+ * written once for Particle<D>, the loops over the coordinates have compile
+ * time bounds and are unrolled by the compiler.
+ */
+template <std::size_t D>
+struct Particle {
+    static constexpr std::size_t dim = D;
+
+    Particle(double q, const std::array<double, D> &x) : q(q), x(x) {}
+
+    /**
+     * Constructor taking the charge and the D coordinates.
+     */
+    template <typename... Coordinates,
+              typename = typename std::enable_if<sizeof...(Coordinates) ==
+                                                 D>::type>
+    Particle(double q, Coordinates... x)
+        : q(q), x{{static_cast<double>(x)...}} {}
 
-struct Particle2D {
-    Particle2D(double q, double x, double y) : q(q), x(x), y(y) {}
     double q = 1.0;
-    double x = 0.0;
-    double y = 0.0;
+    std::array<double, D> x;
 };
 
-struct Particle3D {
-    Particle3D(double q, double x, double y, double z)
-        : q(q), x(x), y(y), z(z) {}
-    double q = 1.0;
-    double x = 0.0;
-    double y = 0.0;
-    double z = 0.0;
+template <std::size_t D>
+constexpr std::size_t Particle<D>::dim;
+
+using Particle2D = Particle<2>;
+using Particle3D = Particle<3>;
+
+template <std::size_t D>
+struct ParticleTraits<Particle<D>> {
+    static constexpr std::size_t dim = D;
+    static double coordinate(const Particle<D> &p, std::size_t d) {
+        return p.x[d];
+    }
+    static Particle<D> make(double q, const double *x) {
+        std::array<double, D> coords;
+        std::copy(x, x + D, coords.begin());
+        return Particle<D>(q, coords);
+    }
 };
 
-double coulomb_core(const Particle2D &a, const Particle2D &b);
-double coulomb_core(const Particle3D &a, const Particle3D &b);
+template <std::size_t D>
+constexpr std::size_t ParticleTraits<Particle<D>>::dim;
+
+template <std::size_t D>
+double coulomb_core(const Particle<D> &a, const Particle<D> &b) {
+    return coulomb_core_kernel(distance_sq(a, b), a.q * b.q);
+}
+
+template <std::size_t D>
+double lennard_jones(const Particle<D> &a, const Particle<D> &b) {
+    return lennard_jones_kernel(distance_sq(a, b));
+}
+
+/**
+ * Central force factor(r^2) * r for the displacement r of a particle from
+ * its partner.
+ */
+template <std::size_t D, typename Factor>
+std::array<double, D> central_force(std::array<double, D> r, Factor factor) {
+    auto r2 = 0.0;
+    for (const auto x : r) {
+        r2 += x * x;
+    }
+    const auto f = factor(r2);
+    for (auto &x : r) {
+        x *= f;
+    }
+    return r;
+}
+
+/**
+ * Force exerted by b on a, minus the gradient of coulomb_core with respect
+ * to the coordinates of a. A positive box length selects the minimum image.
+ */
+template <std::size_t D>
+std::array<double, D> coulomb_core_force(const Particle<D> &a,
+                                         const Particle<D> &b,
+                                         double box_length = 0.0) {
+    const auto qq = a.q * b.q;
+    return central_force(displacement(a, b, box_length), [qq](double r2) {
+        return coulomb_core_force_kernel(r2, qq);
+    });
+}
+
+/**
+ * Force exerted by b on a, see coulomb_core_force.
+ */
+template <std::size_t D>
+std::array<double, D> lennard_jones_force(const Particle<D> &a,
+                                          const Particle<D> &b,
+                                          double box_length = 0.0) {
+    return central_force(displacement(a, b, box_length), [](double r2) {
+        return lennard_jones_force_kernel(r2);
+    });
+}
+
+/**
+ * Function object calling coulomb_core. Used as compile-time potential policy
+ * of CanonicalEnsemble, which allows the pair potential to be inlined. The
+ * energy row is evaluated by the SIMD kernel coulomb_core_row. A positive box
+ * length selects periodic boundaries with minimum image distances.
+ */
+struct CoulombCore {
+    explicit CoulombCore(double box_length = 0.0) : box_length(box_length) {}
 
-double lennard_jones(const Particle2D &a, const Particle2D &b);
-double lennard_jones(const Particle3D &a, const Particle3D &b);
+    template <typename ParticleState>
+    double operator()(const ParticleState &a, const ParticleState &b) const {
+        if (box_length > 0.0) {
+            return coulomb_core_kernel(distance_sq(a, b, box_length),
+                                       a.q * b.q);
+        }
+        return coulomb_core(a, b);
+    }
+
+    template <std::size_t Dim, typename ParticleState>
+    double row(const SoAState<Dim> &state, const ParticleState &p,
+               std::size_t ix, double *out) const {
+        return coulomb_core_row(state, coordinates(p), p.q, ix, out,
+                                box_length);
+    }
+
+    /**
+     * Lower bound of the pair energy, used for early rejection.
+     */
+    template <typename ParticleState>
+    double min_pair_energy(const ParticleState &a,
+                           const ParticleState &b) const {
+        return coulomb_core_min(a.q * b.q);
+    }
+
+    /**
+     * Force exerted by b on a, used by HybridMonteCarlo.
+     */
+    template <typename ParticleState>
+    std::array<double, ParticleTraits<ParticleState>::dim>
+    force(const ParticleState &a, const ParticleState &b) const {
+        return coulomb_core_force(a, b, box_length);
+    }
+
+    double box_length;
+};
+
+/**
+ * Function object calling lennard_jones. Used as compile-time potential
+ * policy of CanonicalEnsemble, which allows the pair potential to be inlined.
+ * The energy row is evaluated by the SIMD kernel lennard_jones_row. A
+ * positive box length selects periodic boundaries, see CoulombCore.
+ */
+struct LennardJones {
+    explicit LennardJones(double box_length = 0.0)
+        : box_length(box_length) {}
+
+    template <typename ParticleState>
+    double operator()(const ParticleState &a, const ParticleState &b) const {
+        if (box_length > 0.0) {
+            return lennard_jones_kernel(distance_sq(a, b, box_length));
+        }
+        return lennard_jones(a, b);
+    }
+
+    template <std::size_t Dim, typename ParticleState>
+    double row(const SoAState<Dim> &state, const ParticleState &p,
+               std::size_t ix, double *out) const {
+        return lennard_jones_row(state, coordinates(p), p.q, ix, out,
+                                 box_length);
+    }
+
+    template <typename ParticleState>
+    double min_pair_energy(const ParticleState &,
+                           const ParticleState &) const {
+        return lennard_jones_min;
+    }
+
+    template <typename ParticleState>
+    std::array<double, ParticleTraits<ParticleState>::dim>
+    force(const ParticleState &a, const ParticleState &b) const {
+        return lennard_jones_force(a, b, box_length);
+    }
+
+    double box_length;
+};
 
-double avg_pair_dist(const CanonicalEnsemble<Particle2D>::State &state);
-double avg_pair_dist(const CanonicalEnsemble<Particle3D>::State &state);
+template <std::size_t D>
+double avg_pair_dist(const std::vector<Particle<D>> &state) {
+    const auto N = state.size();
+    double distance = 0.0;
+    for (auto it = state.cbegin(), end = state.cend(); it != end; ++it) {
+        for (auto it2 = state.cbegin(); it2 != it; ++it2) {
+            distance += std::sqrt(distance_sq(*it, *it2));
+        }
+    }
+    return 2.0 / static_cast<double>(N * (N - 1)) * distance;
+}
 
 #endif // PARTICLE_H_
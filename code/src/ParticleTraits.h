@@ -0,0 +1,88 @@
+#ifndef PARTICLETRAITS_H_
+#define PARTICLETRAITS_H_
+
+#include <array>
+#include <cstddef>
+
+#include "Boundary.h"
+
+/**
+ * ParticleTraits
+ *
+ * Gives generic code access to the dimension and the coordinates of a particle
+ * type. Has to be specialized for every particle type, providing
+ *     static constexpr std::size_t dim;
+ *     static double coordinate(const ParticleState &p, std::size_t d);
+ *     static ParticleState make(double q, const double *x);
+ */
+template <typename ParticleState>
+struct ParticleTraits;
+
+/**
+ * Squared euclidean distance between two particles.
+ */
+template <typename ParticleState>
+double distance_sq(const ParticleState &a, const ParticleState &b) {
+    using Traits = ParticleTraits<ParticleState>;
+    auto ret = 0.0;
+    for (std::size_t d = 0; d < Traits::dim; ++d) {
+        const auto diff = Traits::coordinate(a, d) - Traits::coordinate(b, d);
+        ret += diff * diff;
+    }
+    return ret;
+}
+
+/**
+ * Squared distance between two particles in a periodic box with side length
+ * box_length following the minimum image convention. box_length = 0 denotes
+ * an open box.
+ */
+template <typename ParticleState>
+double distance_sq(const ParticleState &a, const ParticleState &b,
+                   double box_length) {
+    using Traits = ParticleTraits<ParticleState>;
+    const auto inv_box_length = box_length > 0.0 ? 1.0 / box_length : 0.0;
+    auto ret = 0.0;
+    for (std::size_t d = 0; d < Traits::dim; ++d) {
+        const auto diff =
+            minimum_image(Traits::coordinate(a, d) - Traits::coordinate(b, d),
+                          box_length, inv_box_length);
+        ret += diff * diff;
+    }
+    return ret;
+}
+
+/**
+ * Difference a - b of the coordinates of two particles, the minimum image in
+ * a periodic box with side length box_length > 0.
+ */
+template <typename ParticleState>
+std::array<double, ParticleTraits<ParticleState>::dim>
+displacement(const ParticleState &a, const ParticleState &b,
+             double box_length = 0.0) {
+    using Traits = ParticleTraits<ParticleState>;
+    const auto inv_box_length = box_length > 0.0 ? 1.0 / box_length : 0.0;
+    std::array<double, Traits::dim> ret;
+    for (std::size_t d = 0; d < Traits::dim; ++d) {
+        ret[d] =
+            minimum_image(Traits::coordinate(a, d) - Traits::coordinate(b, d),
+                          box_length, inv_box_length);
+    }
+    return ret;
+}
+
+/**
+ * Coordinates of a particle as an array.
+ */
+template <typename ParticleState>
+std::array<double, ParticleTraits<ParticleState>::dim>
+coordinates(const ParticleState &p) {
+    using Traits = ParticleTraits<ParticleState>;
+    std::array<double, Traits::dim> ret;
+    for (std::size_t d = 0; d < Traits::dim; ++d) {
+        ret[d] = Traits::coordinate(p, d);
+    }
+    return ret;
+}
+
+#endif // PARTICLETRAITS_H_
@@ -0,0 +1,90 @@
+#ifndef POTENTIALKERNELS_H_
+#define POTENTIALKERNELS_H_
+
+#include <cmath>
+
+/**
+ * Computes x^N by repeated squaring, so that integer powers of the distance
+ * do not go through std::pow.
+ */
+template <unsigned N>
+inline double int_pow(double x) {
+    const auto half = int_pow<N / 2>(x);
+    return N % 2 == 0 ? half * half : half * half * x;
+}
+
+template <>
+inline double int_pow<0>(double) {
+    return 1.0;
+}
+
+template <>
+inline double int_pow<1>(double x) {
+    return x;
+}
+
+/**
+ * Coulomb potential with a r^-8 hard core as a function of the squared
+ * distance and the product of the charges.
+ */
+inline double coulomb_core_kernel(double distance_sq, double qq) {
+    const auto inv_r2 = 1.0 / distance_sq;
+    return qq * std::sqrt(inv_r2) + int_pow<4>(inv_r2);
+}
+
+/**
+ * Radial force of coulomb_core_kernel divided by the distance, -V'(r) / r,
+ * so that the force on a particle is this factor times its displacement
+ * from the partner.
+ */
+inline double coulomb_core_force_kernel(double distance_sq, double qq) {
+    const auto inv_r2 = 1.0 / distance_sq;
+    return qq * inv_r2 * std::sqrt(inv_r2) + 8.0 * int_pow<5>(inv_r2);
+}
+
+/**
+ * Real-space part of coulomb_core in the Ewald sum: the Coulomb term is
+ * screened by erfc(alpha r), the core is kept.
+ */
+inline double ewald_core_kernel(double distance_sq, double qq, double alpha) {
+    const auto r = std::sqrt(distance_sq);
+    return qq * std::erfc(alpha * r) / r + int_pow<4>(1.0 / distance_sq);
+}
+
+/**
+ * Minimum of coulomb_core_kernel over all distances for the product of the
+ * charges qq. For qq < 0 it lies at r^7 = 8 / |qq|, like charges repel at
+ * every distance.
+ */
+inline double coulomb_core_min(double qq) {
+    if (qq >= 0.0) {
+        return 0.0;
+    }
+    return -0.875 * std::pow(int_pow<8>(qq) / 8.0, 1.0 / 7.0);
+}
+
+/**
+ * Lennard-Jones potential as a function of the squared distance. Both terms
+ * share the reciprocal 1 / r^2.
+ */
+inline double lennard_jones_kernel(double distance_sq) {
+    const auto inv_r6 = int_pow<3>(1.0 / distance_sq);
+    return inv_r6 * inv_r6 - inv_r6;
+}
+
+/**
+ * Radial force of lennard_jones_kernel divided by the distance, see
+ * coulomb_core_force_kernel.
+ */
+inline double lennard_jones_force_kernel(double distance_sq) {
+    const auto inv_r2 = 1.0 / distance_sq;
+    const auto inv_r6 = int_pow<3>(inv_r2);
+    return (12.0 * inv_r6 - 6.0) * inv_r6 * inv_r2;
+}
+
+/**
+ * Minimum of lennard_jones_kernel, attained at r^6 = 2.
+ */
+constexpr double lennard_jones_min = -0.25;
+
+#endif // POTENTIALKERNELS_H_
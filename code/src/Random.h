@@ -0,0 +1,263 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <random>
+
+/**
+ * SplitMix64, used to expand a seed into generator states.
+ */
+inline std::uint64_t splitmix64(std::uint64_t &x) {
+    auto z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seed of a random number stream: a master seed shared by a whole run and the
+ * index of the stream, e.g. of a chain or a replica. Generators created from
+ * equal seeds produce equal sequences, independently of the thread they run
+ * on.
+ */
+struct Seed {
+    std::uint64_t master;
+    std::uint64_t stream;
+};
+
+/**
+ * Mixes master seed and stream index into a single 64 bit seed.
+ */
+inline std::uint64_t stream_seed(const Seed &seed) {
+    auto x = seed.master;
+    auto y = splitmix64(x) ^ seed.stream;
+    return splitmix64(y);
+}
+
+/**
+ * Seed with a master seed drawn from std::random_device, for runs that need
+ * not be reproducible.
+ */
+inline Seed random_seed() {
+    std::random_device device;
+    const auto hi = static_cast<std::uint64_t>(device());
+    return Seed{(hi << 32) | device(), 0};
+}
+
+/**
+ * Xoshiro256
+ *
+ * xoshiro256++ generator by Blackman and Vigna, period 2^256 - 1. Satisfies
+ * UniformRandomBitGenerator, so it works with the standard distributions.
+ * jump() and long_jump() advance the generator by 2^128 and 2^192 steps,
+ * which splits the sequence into non-overlapping streams. Like the standard
+ * engines, the state can be written to and read from streams.
+ */
+class Xoshiro256 {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+public:
+    explicit Xoshiro256(std::uint64_t seed = 0) {
+        for (auto &word : s) {
+            word = splitmix64(seed);
+        }
+    }
+
+    result_type operator()() {
+        const auto ret = rotl(s[0] + s[3], 23) + s[0];
+        const auto t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return ret;
+    }
+
+    /**
+     * Advances the generator by 2^128 steps.
+     */
+    void jump() {
+        static const std::uint64_t polynomial[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+            0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        jump(polynomial);
+    }
+
+    /**
+     * Advances the generator by 2^192 steps.
+     */
+    void long_jump() {
+        static const std::uint64_t polynomial[] = {
+            0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+            0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+        jump(polynomial);
+    }
+
+    const std::array<std::uint64_t, 4> &get_state() const { return s; }
+
+    friend std::ostream &operator<<(std::ostream &os, const Xoshiro256 &rng) {
+        return os << rng.s[0] << ' ' << rng.s[1] << ' ' << rng.s[2] << ' '
+                  << rng.s[3];
+    }
+
+    friend std::istream &operator>>(std::istream &is, Xoshiro256 &rng) {
+        return is >> rng.s[0] >> rng.s[1] >> rng.s[2] >> rng.s[3];
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    void jump(const std::uint64_t *polynomial) {
+        std::array<std::uint64_t, 4> t = {{0, 0, 0, 0}};
+        for (std::size_t i = 0; i < 4; ++i) {
+            for (int b = 0; b < 64; ++b) {
+                if (polynomial[i] & (std::uint64_t(1) << b)) {
+                    for (std::size_t k = 0; k < 4; ++k) {
+                        t[k] ^= s[k];
+                    }
+                }
+                (*this)();
+            }
+        }
+        s = t;
+    }
+
+private:
+    std::array<std::uint64_t, 4> s;
+};
+
+/**
+ * XoshiroBatch
+ *
+ * Runs several xoshiro256++ generators side by side and hands out their
+ * output from a buffer refilled in bulk. The state is stored lane-wise, so
+ * that the refill loop is vectorized by the compiler. Every stream of a
+ * master seed starts from its own stream_seed(), and its lanes are separated
+ * by jumps of 2^128 steps, so they never overlap.
+ */
+class XoshiroBatch {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    /**
+     * Number of interleaved generators and of outputs per refill.
+     */
+    static constexpr std::size_t lanes = 8;
+    static constexpr std::size_t buffer_size = 32 * lanes;
+
+public:
+    /**
+     * Constructor taking the master seed and the index of the stream.
+     */
+    explicit XoshiroBatch(std::uint64_t seed = 0, std::uint64_t stream = 0) {
+        Xoshiro256 master(stream_seed(Seed{seed, stream}));
+        for (std::size_t l = 0; l < lanes; ++l) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                s[k][l] = master.get_state()[k];
+            }
+            master.jump();
+        }
+    }
+
+    result_type operator()() {
+        if (pos == buffer_size) {
+            refill();
+        }
+        return buffer[pos++];
+    }
+
+    /**
+     * Writes the state of all lanes together with the buffered outputs, so
+     * that a restored generator continues the same sequence.
+     */
+    friend std::ostream &operator<<(std::ostream &os,
+                                    const XoshiroBatch &rng) {
+        for (const auto &word : rng.s) {
+            for (const auto lane : word) {
+                os << lane << ' ';
+            }
+        }
+        for (const auto value : rng.buffer) {
+            os << value << ' ';
+        }
+        return os << rng.pos;
+    }
+
+    friend std::istream &operator>>(std::istream &is, XoshiroBatch &rng) {
+        for (auto &word : rng.s) {
+            for (auto &lane : word) {
+                is >> lane;
+            }
+        }
+        for (auto &value : rng.buffer) {
+            is >> value;
+        }
+        is >> rng.pos;
+        if (rng.pos > buffer_size) {
+            is.setstate(std::ios::failbit);
+        }
+        return is;
+    }
+
+private:
+    void refill() {
+        for (std::size_t r = 0; r < buffer_size; r += lanes) {
+            for (std::size_t l = 0; l < lanes; ++l) {
+                const auto sum = s[0][l] + s[3][l];
+                buffer[r + l] = ((sum << 23) | (sum >> 41)) + s[0][l];
+                const auto t = s[1][l] << 17;
+                s[2][l] ^= s[0][l];
+                s[3][l] ^= s[1][l];
+                s[1][l] ^= s[2][l];
+                s[0][l] ^= s[3][l];
+                s[2][l] ^= t;
+                s[3][l] = (s[3][l] << 45) | (s[3][l] >> 19);
+            }
+        }
+        pos = 0;
+    }
+
+private:
+    std::uint64_t s[4][lanes];
+    std::uint64_t buffer[buffer_size];
+    std::size_t pos = buffer_size;
+};
+
+/**
+ * Creates a generator seeded from a stream seed. Generic version for the
+ * standard engines, which are seeded through std::seed_seq.
+ */
+template <typename Rng>
+Rng make_rng(const Seed &seed) {
+    const auto s = stream_seed(seed);
+    std::seed_seq seq{static_cast<std::uint32_t>(s),
+                      static_cast<std::uint32_t>(s >> 32)};
+    return Rng(seq);
+}
+
+template <>
+inline Xoshiro256 make_rng<Xoshiro256>(const Seed &seed) {
+    return Xoshiro256(stream_seed(seed));
+}
+
+template <>
+inline XoshiroBatch make_rng<XoshiroBatch>(const Seed &seed) {
+    return XoshiroBatch(seed.master, seed.stream);
+}
+
+#endif // RANDOM_H_
@@ -0,0 +1,384 @@
+#include "Run.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+#include "Ewald.h"
+#include "HybridMonteCarlo.h"
+#include "ObservableSweep.h"
+#include "Observables.h"
+#include "ParallelTempering.h"
+#include "Random.h"
+#include "StepSizeTuner.h"
+#include "TrajectoryWriter.h"
+
+/**
+ * Moves of the chains of the configured system.
+ */
+ChainSettings chain_settings(const RunConfig &config) {
+    ChainSettings settings;
+    settings.delta = config.delta;
+    settings.box_length = config.box;
+    settings.boundary = config.boundary;
+    settings.hmc_interval = config.hmc_interval;
+    settings.hmc_length = config.hmc_length;
+    settings.hmc_dt = config.hmc_dt;
+    return settings;
+}
+
+/**
+ * Convergence criterion, threads and files of sweep. The options are
+ * written to the table header, an interrupted sweep is only resumed if
+ * they are unchanged.
+ */
+SweepSettings sweep_settings(const RunConfig &config) {
+    SweepSettings settings;
+    settings.tolerance = config.tolerance;
+    settings.min_steps = config.min_steps;
+    settings.max_steps = config.max_steps;
+    settings.max_chains = config.max_chains;
+    settings.repeat = config.repeat;
+    settings.threads = config.threads;
+    settings.seed = config.seed;
+    settings.output = config.output;
+    settings.checkpoint = config.checkpoint;
+    std::stringstream options;
+    print_config(options, config, "# ");
+    settings.description = options.str();
+    return settings;
+}
+
+double periodic_length(const RunConfig &config) {
+    return periodic_length(chain_settings(config));
+}
+
+/**
+ * Selects the overload of make_potential constructing T.
+ */
+template <typename T>
+struct Tag {};
+
+CoulombCore make_potential(Tag<CoulombCore>, const RunConfig &) {
+    return CoulombCore();
+}
+
+LennardJones make_potential(Tag<LennardJones>, const RunConfig &config) {
+    return LennardJones(periodic_length(config));
+}
+
+template <typename ParticleState>
+EwaldCoulombCore<ParticleState>
+make_potential(Tag<EwaldCoulombCore<ParticleState>>,
+               const RunConfig &config) {
+    return EwaldCoulombCore<ParticleState>(
+        config.box, effective_cutoff(config), 1e-5, config.long_range);
+}
+
+/**
+ * Ensemble of the configured system. Potential and proposal are
+ * compile-time policies, the options only select among the
+ * specializations in main().
+ */
+template <typename ParticleState, typename Potential>
+using Ensemble =
+    CanonicalEnsemble<ParticleState, Potential,
+                      UniformProposal<ParticleTraits<ParticleState>::dim>,
+                      XoshiroBatch>;
+
+/**
+ * Creates an ensemble at beta with a random initial state, both drawn from
+ * the stream seed. Cell list, Verlet lists if configured and energy cache
+ * are enabled.
+ */
+template <typename ParticleState, typename Potential>
+Ensemble<ParticleState, Potential>
+make_ensemble(const RunConfig &config, double beta, const Seed &seed) {
+    constexpr auto dim = ParticleTraits<ParticleState>::dim;
+    using Proposal = UniformProposal<dim>;
+
+    Ensemble<ParticleState, Potential> ensemble(
+        random_state<dim>(config.box, static_cast<unsigned>(config.pairs),
+                          seed),
+        beta,
+        make_potential(Tag<Potential>(), config),
+        Proposal(config.delta, config.box, config.boundary), seed);
+    const auto cutoff = effective_cutoff(config);
+    if (cutoff > 0.0) {
+        ensemble.enable_cell_list(config.box, cutoff, config.boundary);
+        if (config.skin > 0.0) {
+            ensemble.enable_neighbour_list(config.skin);
+        }
+    }
+    ensemble.enable_energy_cache();
+    return ensemble;
+}
+
+/**
+ * Runs the steps of sample by checkerboard sweeps on the configured
+ * threads, each sweep counts as many steps as there are particles. The
+ * trajectory gets a frame per sweep.
+ * returns: number of accepted steps
+ */
+template <typename Ensemble, typename Writer>
+std::size_t sample_checkerboard(const RunConfig &config, Ensemble &ensemble,
+                                Writer &writer, std::true_type) {
+    ensemble.enable_checkerboard();
+    ThreadPool pool(n_threads(config.threads));
+    const auto n = ensemble.get_state().size();
+    std::size_t accepted_cnt = 0;
+    for (std::size_t i = 0; i < config.steps; i += n) {
+        accepted_cnt += ensemble.checkerboard_sweep(pool);
+        writer.write(ensemble.get_state());
+    }
+    return accepted_cnt;
+}
+
+/**
+ * The long-range part of Ewald sums couples all particles, validate_config
+ * rejects checkerboard sweeps of them.
+ */
+template <typename Ensemble, typename Writer>
+std::size_t sample_checkerboard(const RunConfig &, Ensemble &, Writer &,
+                                std::false_type) {
+    throw std::logic_error("checkerboard sweeps need a potential without "
+                           "long-range part");
+}
+
+/**
+ * Runs a single chain at beta and streams its states to a binary
+ * trajectory, convert it with traj2tsv.
+ */
+template <typename ParticleState, typename Potential>
+int run_sample(const RunConfig &config, std::uint64_t master_seed) {
+    auto ensemble = make_ensemble<ParticleState, Potential>(
+        config, config.beta, Seed{master_seed, 0});
+
+    const auto filename =
+        config.output.empty() ? std::string("out.traj") : config.output;
+    TrajectoryWriter<ParticleState> writer(
+        filename, ensemble.get_state(), config.box, config.beta,
+        static_cast<Precision>(config.precision), config.stride);
+    if (!writer.is_open()) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return 1;
+    }
+
+    auto steps = config.steps;
+    std::size_t accepted_cnt = 0;
+    std::size_t hmc_accepted_cnt = 0;
+    if (config.checkerboard) {
+        // Whole sweeps
+        const auto n = ensemble.get_state().size();
+        steps = (steps + n - 1) / n * n;
+        accepted_cnt = sample_checkerboard(
+            config, ensemble, writer,
+            std::integral_constant<bool, !HasLongRange<Potential>::value>());
+    } else {
+        // Trajectories of all particles are interleaved with the steps
+        const auto settings = chain_settings(config);
+        auto hmc = make_hmc<Ensemble<ParticleState, Potential>>(
+            settings, Seed{master_seed, 0});
+        for (std::size_t i = 0; i < config.steps; ++i) {
+            if (ensemble.step()) {
+                ++accepted_cnt;
+            }
+            if (hmc_due(settings, i + 1) &&
+                hmc_step(hmc, ensemble, HasForce<Potential, ParticleState>())) {
+                ++hmc_accepted_cnt;
+            }
+            writer.write(ensemble.get_state());
+        }
+    }
+
+    std::cout << "Master seed: " << master_seed << "\n";
+    std::cout << "Acceptance probability: "
+              << static_cast<double>(accepted_cnt) / steps << "\n";
+    if (config.hmc_interval > 0 && config.steps >= config.hmc_interval) {
+        std::cout << "HMC acceptance probability: "
+                  << static_cast<double>(hmc_accepted_cnt) /
+                         (config.steps / config.hmc_interval)
+                  << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}
+
+/**
+ * Runs chains over the beta ladder until the error bar of the observable
+ * drops below the tolerance and writes the results to a CSV table, see
+ * run_observable_sweep(). Sweep i uses master seed seed + i if a seed is
+ * given. An interrupted sweep is resumed from its checkpoints if the
+ * options are unchanged.
+ */
+template <typename ParticleState, typename Potential>
+int run_sweep(const RunConfig &config) {
+    return run_observable_sweep(
+        beta_ladder(config), sweep_settings(config), chain_settings(config),
+        [&config](double beta, const Seed &seed) {
+            return make_ensemble<ParticleState, Potential>(config, beta, seed);
+        });
+}
+
+/**
+ * Parallel tempering over the beta ladder. The step size of every replica
+ * is tuned to 30% acceptance before the exchanges start and frozen
+ * afterwards. Replica i draws from stream i of the master seed, the
+ * exchanges from the stream following the last replica.
+ */
+template <typename ParticleState, typename Potential>
+int run_tempering(const RunConfig &config, std::uint64_t master_seed) {
+    using Ensemble = ::Ensemble<ParticleState, Potential>;
+
+    std::vector<Ensemble> replicas;
+    for (const auto beta : beta_ladder(config)) {
+        const Seed seed{master_seed, replicas.size()};
+        replicas.push_back(
+            make_ensemble<ParticleState, Potential>(config, beta, seed));
+
+        auto &replica = replicas.back();
+        StepSizeTuner tuner(config.delta, config.box);
+        for (std::size_t i = 0; i < config.tuning_steps; ++i) {
+            if (tuner.add(replica.step())) {
+                replica.get_proposal().set_delta(tuner.get_delta());
+            }
+        }
+    }
+
+    // Timing
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    const Seed exchange_seed{master_seed, replicas.size()};
+    ParallelTempering<Ensemble> tempering(std::move(replicas),
+                                          config.round_steps,
+                                          n_threads(config.threads),
+                                          exchange_seed);
+    tempering.burn_in(config.burn_in_rounds);
+    const auto box_length = periodic_length(config);
+    tempering.run(config.rounds,
+                  [box_length](const typename Ensemble::State &state) {
+                      return AvgPairDistance<ParticleState>(state, box_length)
+                          .value();
+                  });
+
+    const auto time = std::time(nullptr);
+    const auto filename = output_name(config.output, "_pt.csv");
+    std::ofstream os(filename);
+    if (!os) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return 1;
+    }
+
+    // Table header
+    os << "# End of simulation: " << std::ctime(&time);
+    os << "# Master seed: " << master_seed << "\n";
+    print_config(os, config, "# ");
+    os << "beta,acc,obs,energy,swap\n";
+
+    for (const auto &result : tempering.results()) {
+        os << result.beta << "," << result.acceptance << ","
+           << result.observable << "," << result.energy << ","
+           << result.swap_rate << "\n";
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::minutes>(end - start);
+    std::cout << filename << ": " << elapsed.count() << " min" << std::endl;
+    return 0;
+}
+
+template <typename ParticleState, typename Potential>
+int run(const RunConfig &config) {
+    const auto master_seed =
+        config.seed != 0 ? config.seed : random_seed().master;
+    switch (config.mode) {
+    case RunMode::sample:
+        return run_sample<ParticleState, Potential>(config, master_seed);
+    case RunMode::tempering:
+        return run_tempering<ParticleState, Potential>(config, master_seed);
+    default:
+        return run_sweep<ParticleState, Potential>(config);
+    }
+}
+
+/**
+ * Coulomb in a periodic box is evaluated by Ewald summation, which exists
+ * for 2 and 3 dimensions.
+ */
+template <typename ParticleState>
+int run_periodic_coulomb(const RunConfig &config, std::true_type) {
+    return run<ParticleState, EwaldCoulombCore<ParticleState>>(config);
+}
+
+template <typename ParticleState>
+int run_periodic_coulomb(const RunConfig &, std::false_type) {
+    std::cerr << "Coulomb in a periodic box needs dim = 2 or 3" << std::endl;
+    return 1;
+}
+
+/**
+ * Selects the potential.
+ */
+template <typename ParticleState>
+int run(const RunConfig &config) {
+    constexpr auto dim = ParticleTraits<ParticleState>::dim;
+    if (config.potential == PotentialType::lennard_jones) {
+        return run<ParticleState, LennardJones>(config);
+    }
+    if (config.boundary == Boundary::periodic) {
+        return run_periodic_coulomb<ParticleState>(
+            config, std::integral_constant<bool, dim == 2 || dim == 3>());
+    }
+    return run<ParticleState, CoulombCore>(config);
+}
+
+int run(const RunConfig &config) {
+    switch (config.dim) {
+    case 1:
+        return run<Particle<1>>(config);
+    case 3:
+        return run<Particle<3>>(config);
+    case 4:
+        return run<Particle<4>>(config);
+    default:
+        return run<Particle<2>>(config);
+    }
+}
+
+int run_main(int argc, const char *const argv[], const std::string &name,
+             const RunConfig &defaults) {
+    auto config = defaults;
+    bool help = false;
+    std::string error;
+    if (!parse_arguments(argc, argv, config, help, error)) {
+        std::cerr << error << "\nSee " << name << " --help" << std::endl;
+        return 1;
+    }
+    if (help) {
+        std::cout << "Usage: " << name
+                  << " [--config=<file>] [--<key>=<value> ...]\n"
+                     "\n"
+                     "Options are read from the config file, lines of key = "
+                     "value, and\n"
+                     "overridden by the command line. The defaults are:\n"
+                     "\n";
+        print_config(std::cout, defaults, "    ");
+        return 0;
+    }
+    if (!validate_config(config, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    return run(config);
+}
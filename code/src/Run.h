@@ -0,0 +1,24 @@
+#ifndef RUN_H_
+#define RUN_H_
+
+#include <string>
+
+#include "RunConfig.h"
+
+/**
+ * Runs the configured system in the configured mode, see RunMode. The
+ * options must have passed validate_config().
+ * returns: exit code of the program
+ */
+int run(const RunConfig &config);
+
+/**
+ * Main function of piap and of the drivers presetting its options: reads
+ * the command line on top of defaults, prints the usage of the program
+ * name for --help, checks the options and runs them.
+ * returns: exit code of the program
+ */
+int run_main(int argc, const char *const argv[], const std::string &name,
+             const RunConfig &defaults);
+
+#endif // RUN_H_
@@ -0,0 +1,374 @@
+#include "RunConfig.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+const char *const mode_names[] = {"sample", "sweep", "tempering"};
+const char *const potential_names[] = {"coulomb", "lennard_jones"};
+const char *const boundary_names[] = {"hard", "periodic", "reflecting"};
+const char *const long_range_names[] = {"ewald", "pme"};
+
+std::string trim(const std::string &text) {
+    const auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return "";
+    }
+    const auto last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * Parses the whole text as a number, negative numbers are rejected for
+ * unsigned types.
+ */
+template <typename T>
+bool parse_number(const std::string &text, T &value) {
+    if (!std::numeric_limits<T>::is_signed &&
+        text.find('-') != std::string::npos) {
+        return false;
+    }
+    std::istringstream ss(text);
+    T parsed;
+    if (!(ss >> parsed)) {
+        return false;
+    }
+    ss >> std::ws;
+    if (!ss.eof()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+/**
+ * Parses text as one of the names, the enumerator is given by its index.
+ */
+template <typename Enum, std::size_t N>
+bool parse_name(const std::string &text, const char *const (&names)[N],
+                Enum &value) {
+    for (std::size_t i = 0; i < N; ++i) {
+        if (text == names[i]) {
+            value = static_cast<Enum>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_list(const std::string &text, std::vector<double> &values) {
+    std::vector<double> parsed;
+    std::istringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        double value = 0.0;
+        if (!parse_number(trim(item), value)) {
+            return false;
+        }
+        parsed.push_back(value);
+    }
+    values = parsed;
+    return true;
+}
+
+} // namespace
+
+bool set_option(RunConfig &config, const std::string &key,
+                const std::string &value, std::string &error) {
+    bool ok = false;
+    if (key == "mode") {
+        ok = parse_name(value, mode_names, config.mode);
+    } else if (key == "potential") {
+        ok = parse_name(value, potential_names, config.potential);
+    } else if (key == "dim") {
+        ok = parse_number(value, config.dim);
+    } else if (key == "pairs") {
+        ok = parse_number(value, config.pairs);
+    } else if (key == "box") {
+        ok = parse_number(value, config.box);
+    } else if (key == "boundary") {
+        ok = parse_name(value, boundary_names, config.boundary);
+    } else if (key == "cutoff") {
+        ok = parse_number(value, config.cutoff);
+    } else if (key == "skin") {
+        ok = parse_number(value, config.skin);
+    } else if (key == "long_range") {
+        ok = parse_name(value, long_range_names, config.long_range);
+    } else if (key == "beta") {
+        ok = parse_number(value, config.beta);
+    } else if (key == "beta_min") {
+        ok = parse_number(value, config.beta_min);
+    } else if (key == "beta_max") {
+        ok = parse_number(value, config.beta_max);
+    } else if (key == "beta_factor") {
+        ok = parse_number(value, config.beta_factor);
+    } else if (key == "betas") {
+        ok = parse_list(value, config.betas);
+    } else if (key == "delta") {
+        ok = parse_number(value, config.delta);
+    } else if (key == "hmc_interval") {
+        ok = parse_number(value, config.hmc_interval);
+    } else if (key == "hmc_length") {
+        ok = parse_number(value, config.hmc_length);
+    } else if (key == "hmc_dt") {
+        ok = parse_number(value, config.hmc_dt);
+    } else if (key == "seed") {
+        ok = parse_number(value, config.seed);
+    } else if (key == "steps") {
+        ok = parse_number(value, config.steps);
+    } else if (key == "checkerboard") {
+        ok = parse_number(value, config.checkerboard);
+    } else if (key == "tolerance") {
+        ok = parse_number(value, config.tolerance);
+    } else if (key == "min_steps") {
+        ok = parse_number(value, config.min_steps);
+    } else if (key == "max_steps") {
+        ok = parse_number(value, config.max_steps);
+    } else if (key == "max_chains") {
+        ok = parse_number(value, config.max_chains);
+    } else if (key == "repeat") {
+        ok = parse_number(value, config.repeat);
+    } else if (key == "threads") {
+        ok = parse_number(value, config.threads);
+    } else if (key == "tuning_steps") {
+        ok = parse_number(value, config.tuning_steps);
+    } else if (key == "round_steps") {
+        ok = parse_number(value, config.round_steps);
+    } else if (key == "burn_in_rounds") {
+        ok = parse_number(value, config.burn_in_rounds);
+    } else if (key == "rounds") {
+        ok = parse_number(value, config.rounds);
+    } else if (key == "output") {
+        config.output = value;
+        ok = true;
+    } else if (key == "stride") {
+        ok = parse_number(value, config.stride);
+    } else if (key == "precision") {
+        ok = parse_number(value, config.precision);
+    } else if (key == "checkpoint") {
+        config.checkpoint = value;
+        ok = true;
+    } else {
+        error = "unknown option: " + key;
+        return false;
+    }
+    if (!ok) {
+        error = "invalid value of " + key + ": " + value;
+    }
+    return ok;
+}
+
+bool read_config(std::istream &is, RunConfig &config, std::string &error) {
+    std::string line;
+    for (std::size_t line_num = 1; std::getline(is, line); ++line_num) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        const auto eq = line.find('=');
+        if (eq == std::string::npos) {
+            error =
+                "line " + std::to_string(line_num) + ": expected key = value";
+            return false;
+        }
+        if (!set_option(config, trim(line.substr(0, eq)),
+                        trim(line.substr(eq + 1)), error)) {
+            error = "line " + std::to_string(line_num) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_arguments(int argc, const char *const argv[], RunConfig &config,
+                     bool &help, std::string &error) {
+    // Split --key=value, the config file is read before the other options
+    std::vector<std::pair<std::string, std::string>> options;
+    std::string config_file;
+    help = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            help = true;
+            return true;
+        }
+        const auto eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+            error = "expected --key=value: " + arg;
+            return false;
+        }
+        auto key = arg.substr(2, eq - 2);
+        auto value = arg.substr(eq + 1);
+        if (key == "config") {
+            config_file = value;
+        } else {
+            options.emplace_back(std::move(key), std::move(value));
+        }
+    }
+
+    if (!config_file.empty()) {
+        std::ifstream is(config_file);
+        if (!is) {
+            error = "cannot open config file: " + config_file;
+            return false;
+        }
+        if (!read_config(is, config, error)) {
+            error = config_file + ", " + error;
+            return false;
+        }
+    }
+    for (const auto &option : options) {
+        if (!set_option(config, option.first, option.second, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validate_config(const RunConfig &config, std::string &error) {
+    if (config.dim < 1 || config.dim > 4) {
+        error = "dim must be 1 to 4";
+    } else if (config.pairs == 0) {
+        error = "pairs must be positive";
+    } else if (!(config.box > 0.0)) {
+        error = "box must be positive";
+    } else if (!(config.delta > 0.0)) {
+        error = "delta must be positive";
+    } else if (config.potential == PotentialType::coulomb &&
+               config.boundary == Boundary::periodic && config.dim != 2 &&
+               config.dim != 3) {
+        error = "Ewald summation of Coulomb in a periodic box needs dim = 2 "
+                "or 3";
+    } else if (config.cutoff < 0.0) {
+        error = "cutoff must not be negative";
+    } else if (config.boundary == Boundary::periodic &&
+               effective_cutoff(config) > config.box / 2.0) {
+        error = "cutoff must not exceed half the box in a periodic box";
+    } else if (config.long_range == LongRange::pme &&
+               (config.potential != PotentialType::coulomb ||
+                config.boundary != Boundary::periodic)) {
+        error = "long_range = pme needs Coulomb in a periodic box";
+    } else if (config.skin < 0.0) {
+        error = "skin must not be negative";
+    } else if (config.skin > 0.0 && effective_cutoff(config) == 0.0) {
+        error = "skin needs a cutoff";
+    } else if (config.checkerboard &&
+               (config.mode != RunMode::sample ||
+                effective_cutoff(config) == 0.0 ||
+                (config.potential == PotentialType::coulomb &&
+                 config.boundary == Boundary::periodic))) {
+        error = "checkerboard needs mode = sample, a cutoff and no Ewald "
+                "summation";
+    } else if (config.hmc_interval > 0 &&
+               (config.mode == RunMode::tempering || config.checkerboard ||
+                (config.potential == PotentialType::coulomb &&
+                 config.boundary == Boundary::periodic))) {
+        error = "hmc_interval needs mode = sample or sweep, no checkerboard "
+                "and no Ewald summation";
+    } else if (!(config.hmc_dt > 0.0) || config.hmc_length == 0) {
+        error = "hmc_dt and hmc_length must be positive";
+    } else if (config.betas.empty() &&
+               !(config.beta_min > 0.0 && config.beta_factor > 1.0 &&
+                 config.beta_max > config.beta_min)) {
+        error = "beta ladder needs 0 < beta_min < beta_max and "
+                "beta_factor > 1";
+    } else if (!std::is_sorted(config.betas.begin(), config.betas.end()) ||
+               (!config.betas.empty() && !(config.betas.front() > 0.0))) {
+        error = "betas must be positive and increasing";
+    } else if (config.mode == RunMode::sweep && !config.output.empty() &&
+               config.repeat != 1) {
+        error = "repeated sweeps need a generated output name";
+    } else if (config.precision != 4 && config.precision != 8) {
+        error = "precision must be 4 or 8";
+    } else if (config.mode == RunMode::sweep && beta_ladder(config).empty()) {
+        error = "sweep needs at least one beta";
+    } else if (config.mode == RunMode::tempering &&
+               beta_ladder(config).size() < 2) {
+        error = "tempering needs at least two betas";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+void print_config(std::ostream &os, const RunConfig &config,
+                  const std::string &prefix) {
+    const auto mode = static_cast<std::size_t>(config.mode);
+    const auto potential = static_cast<std::size_t>(config.potential);
+    const auto boundary = static_cast<std::size_t>(config.boundary);
+    const auto long_range = static_cast<std::size_t>(config.long_range);
+
+    std::ostringstream betas;
+    betas.precision(12);
+    for (std::size_t i = 0; i < config.betas.size(); ++i) {
+        betas << (i > 0 ? "," : "") << config.betas[i];
+    }
+
+    std::ostringstream ss;
+    ss.precision(12);
+    ss << prefix << "mode = " << mode_names[mode] << "\n"
+       << prefix << "potential = " << potential_names[potential] << "\n"
+       << prefix << "dim = " << config.dim << "\n"
+       << prefix << "pairs = " << config.pairs << "\n"
+       << prefix << "box = " << config.box << "\n"
+       << prefix << "boundary = " << boundary_names[boundary] << "\n"
+       << prefix << "cutoff = " << config.cutoff << "\n"
+       << prefix << "skin = " << config.skin << "\n"
+       << prefix << "long_range = " << long_range_names[long_range] << "\n"
+       << prefix << "beta = " << config.beta << "\n"
+       << prefix << "beta_min = " << config.beta_min << "\n"
+       << prefix << "beta_max = " << config.beta_max << "\n"
+       << prefix << "beta_factor = " << config.beta_factor << "\n"
+       << prefix << "betas = " << betas.str() << "\n"
+       << prefix << "delta = " << config.delta << "\n"
+       << prefix << "hmc_interval = " << config.hmc_interval << "\n"
+       << prefix << "hmc_length = " << config.hmc_length << "\n"
+       << prefix << "hmc_dt = " << config.hmc_dt << "\n"
+       << prefix << "seed = " << config.seed << "\n"
+       << prefix << "steps = " << config.steps << "\n"
+       << prefix << "checkerboard = " << config.checkerboard << "\n"
+       << prefix << "tolerance = " << config.tolerance << "\n"
+       << prefix << "min_steps = " << config.min_steps << "\n"
+       << prefix << "max_steps = " << config.max_steps << "\n"
+       << prefix << "max_chains = " << config.max_chains << "\n"
+       << prefix << "repeat = " << config.repeat << "\n"
+       << prefix << "threads = " << config.threads << "\n"
+       << prefix << "tuning_steps = " << config.tuning_steps << "\n"
+       << prefix << "round_steps = " << config.round_steps << "\n"
+       << prefix << "burn_in_rounds = " << config.burn_in_rounds << "\n"
+       << prefix << "rounds = " << config.rounds << "\n"
+       << prefix << "output = " << config.output << "\n"
+       << prefix << "stride = " << config.stride << "\n"
+       << prefix << "precision = " << config.precision << "\n"
+       << prefix << "checkpoint = " << config.checkpoint << "\n";
+    os << ss.str();
+}
+
+std::vector<double> beta_ladder(const RunConfig &config) {
+    if (!config.betas.empty()) {
+        return config.betas;
+    }
+    std::vector<double> betas;
+    for (double beta = config.beta_min; beta < config.beta_max;
+         beta *= config.beta_factor) {
+        betas.push_back(beta);
+    }
+    return betas;
+}
+
+double effective_cutoff(const RunConfig &config) {
+    if (config.cutoff > 0.0) {
+        return config.cutoff;
+    }
+    if (config.potential == PotentialType::lennard_jones) {
+        return 2.5;
+    }
+    if (config.boundary == Boundary::periodic) {
+        return config.box / 2.0;
+    }
+    return 0.0;
+}
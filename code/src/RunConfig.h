@@ -0,0 +1,157 @@
+#ifndef RUNCONFIG_H_
+#define RUNCONFIG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Boundary.h"
+#include "Ewald.h"
+
+/**
+ * What piap does with the configured system.
+ *     sample:    one chain at beta, streamed to a binary trajectory
+ *     sweep:     chains over the beta ladder until the observables converge,
+ *                written to a CSV table
+ *     tempering: parallel tempering over the beta ladder
+ */
+enum class RunMode { sample, sweep, tempering };
+
+/**
+ * Pair potential of the system. Coulomb in a periodic box is evaluated by
+ * Ewald summation.
+ */
+enum class PotentialType { coulomb, lennard_jones };
+
+/**
+ * RunConfig
+ *
+ * Parameters of a piap run. They are read from a config file of lines
+ *
+ *     key = value    # comment
+ *
+ * and from command line options --key=value, which override the file. The
+ * keys are the member names below, print_config() writes them all.
+ */
+struct RunConfig {
+    RunMode mode = RunMode::sweep;
+    PotentialType potential = PotentialType::coulomb;
+    // Dimension of the box, 1 to 4
+    std::size_t dim = 2;
+    // Number of oppositely charged particle pairs
+    std::size_t pairs = 20;
+    // Side length of the box
+    double box = 15.0;
+    Boundary boundary = Boundary::hard;
+    // Cutoff of the cell list, of the real-space Ewald sum for Coulomb in a
+    // periodic box. Zero selects 2.5 for Lennard-Jones, which is negligible
+    // beyond, half the side length for Ewald and no cell list for Coulomb in
+    // a closed box.
+    double cutoff = 0.0;
+    // Skin of the Verlet lists on top of the cell list, zero disables them
+    double skin = 0.0;
+    // Reciprocal part of the Ewald sum: ewald sums over the wave vectors,
+    // pme on a mesh (smooth particle-mesh Ewald)
+    LongRange long_range = LongRange::ewald;
+
+    // Thermodynamic beta of sample
+    double beta = 300.0;
+    // Geometric beta ladder of sweep and tempering from beta_min up to,
+    // excluding, beta_max, replaced by an explicit comma separated list of
+    // betas if given
+    double beta_min = 1.0;
+    double beta_max = 500.0;
+    double beta_factor = 1.04;
+    std::vector<double> betas;
+
+    // Step size of the proposal, the initial one if it is tuned
+    double delta = 1.0;
+    // Hybrid Monte Carlo: single particle steps between two trajectories of
+    // all particles (zero disables them), leapfrog steps per trajectory and
+    // their step size, the initial one if it is tuned
+    std::size_t hmc_interval = 0;
+    std::size_t hmc_length = 20;
+    double hmc_dt = 0.01;
+    // Master seed of all chains, zero draws a random one
+    std::uint64_t seed = 0;
+
+    // Steps of sample
+    std::size_t steps = 100000;
+    // Sample by checkerboard sweeps, which move the particles of distant
+    // domains concurrently on all threads. Needs a cutoff and no Ewald sum.
+    bool checkerboard = false;
+    // Target relative error of the observable and limits of the steps per
+    // beta of sweep, summed over all chains of a beta
+    double tolerance = 1e-3;
+    std::size_t min_steps = 100000;
+    std::size_t max_steps = 15000000;
+    // Chains per beta of sweep, zero is unlimited
+    std::size_t max_chains = 0;
+    // Number of sweeps, zero repeats them forever
+    std::size_t repeat = 1;
+    // Worker threads, zero uses all hardware threads
+    std::size_t threads = 0;
+
+    // Tempering: steps per replica to tune the step size, steps per replica
+    // between two exchanges, rounds of burn-in and measurement
+    std::size_t tuning_steps = 20000;
+    std::size_t round_steps = 100;
+    std::size_t burn_in_rounds = 100;
+    std::size_t rounds = 10000;
+
+    // Output file, empty selects out.traj for sample and a timestamp for the
+    // tables
+    std::string output;
+    // Number of steps per stored frame and bytes per coordinate of sample
+    std::size_t stride = 1;
+    std::size_t precision = 8;
+    // Prefix of the checkpoint files of sweep, empty disables checkpoints
+    std::string checkpoint = "piap";
+};
+
+/**
+ * Sets the option key to the text value. Returns false and describes the
+ * problem in error if the key is unknown or the value invalid.
+ */
+bool set_option(RunConfig &config, const std::string &key,
+                const std::string &value, std::string &error);
+
+/**
+ * Reads the options of a config file.
+ */
+bool read_config(std::istream &is, RunConfig &config, std::string &error);
+
+/**
+ * Reads the command line. A config file given by --config=<file> is read
+ * first, the other options override it. --help sets help.
+ */
+bool parse_arguments(int argc, const char *const argv[], RunConfig &config,
+                     bool &help, std::string &error);
+
+/**
+ * Checks the combination of options.
+ */
+bool validate_config(const RunConfig &config, std::string &error);
+
+/**
+ * Writes all options in config file format, each line prefixed with
+ * prefix.
+ */
+void print_config(std::ostream &os, const RunConfig &config,
+                  const std::string &prefix = "");
+
+/**
+ * The betas of sweep and tempering in increasing order.
+ */
+std::vector<double> beta_ladder(const RunConfig &config);
+
+/**
+ * The cutoff of the cell list or the real-space Ewald sum after applying
+ * the defaults, zero if no cell list is used.
+ */
+double effective_cutoff(const RunConfig &config);
+
+#endif // RUNCONFIG_H_
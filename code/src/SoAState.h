@@ -0,0 +1,144 @@
+#ifndef SOASTATE_H_
+#define SOASTATE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "ParticleTraits.h"
+
+/**
+ * AlignedAllocator
+ *
+ * Allocator returning memory aligned to Alignment bytes, so that the SIMD
+ * kernels can use aligned loads.
+ */
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(std::size_t n) {
+        // Over-allocate and store the original pointer in front of the block
+        const auto raw = static_cast<char *>(
+            ::operator new(n * sizeof(T) + Alignment + sizeof(void *)));
+        const auto addr =
+            reinterpret_cast<std::uintptr_t>(raw + sizeof(void *));
+        const auto aligned = reinterpret_cast<char *>(
+            (addr + Alignment - 1) & ~(std::uintptr_t(Alignment) - 1));
+        reinterpret_cast<void **>(aligned)[-1] = raw;
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    void deallocate(T *p, std::size_t) {
+        ::operator delete(reinterpret_cast<void **>(p)[-1]);
+    }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment> &,
+                const AlignedAllocator<U, Alignment> &) {
+    return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment> &,
+                const AlignedAllocator<U, Alignment> &) {
+    return false;
+}
+
+/**
+ * SoAState
+ *
+ * Structure-of-arrays copy of a state: charges and every coordinate axis are
+ * stored in separate arrays, aligned to 64 bytes and padded to a multiple of
+ * the widest SIMD register (8 doubles). Padding entries carry zero charge and
+ * are masked out by the kernels.
+ */
+template <std::size_t Dim>
+class SoAState {
+public:
+    using Array = std::vector<double, AlignedAllocator<double, 64>>;
+
+    static constexpr std::size_t dim = Dim;
+
+    /**
+     * Number of doubles the arrays are padded to.
+     */
+    static constexpr std::size_t padding = 8;
+
+public:
+    /**
+     * Constructs an empty state.
+     */
+    SoAState() = default;
+
+    /**
+     * Constructs the SoA copy of an AoS state.
+     */
+    template <typename ParticleState>
+    explicit SoAState(const std::vector<ParticleState> &state)
+        : n(state.size()),
+          n_padded((state.size() + padding - 1) / padding * padding),
+          q(n_padded, 0.0) {
+        for (auto &axis : x) {
+            axis.assign(n_padded, 0.0);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            set(i, state[i]);
+        }
+    }
+
+    /**
+     * Overwrites particle ix.
+     */
+    template <typename ParticleState>
+    void set(std::size_t ix, const ParticleState &p) {
+        static_assert(ParticleTraits<ParticleState>::dim == Dim,
+                      "dimension mismatch");
+        q[ix] = p.q;
+        for (std::size_t d = 0; d < Dim; ++d) {
+            x[d][ix] = ParticleTraits<ParticleState>::coordinate(p, d);
+        }
+    }
+
+    /**
+     * Number of particles.
+     */
+    std::size_t size() const { return n; }
+
+    /**
+     * Length of the padded arrays.
+     */
+    std::size_t padded_size() const { return n_padded; }
+
+    const double *charge() const { return q.data(); }
+
+    const double *coordinate(std::size_t d) const { return x[d].data(); }
+
+private:
+    std::size_t n = 0;
+    std::size_t n_padded = 0;
+
+    Array q;
+    std::array<Array, Dim> x;
+};
+
+template <std::size_t Dim>
+constexpr std::size_t SoAState<Dim>::dim;
+
+template <std::size_t Dim>
+constexpr std::size_t SoAState<Dim>::padding;
+
+#endif // SOASTATE_H_
@@ -0,0 +1,52 @@
+#include "SplineTable.h"
+
+#include <cmath>
+
+SplineTable::SplineTable(Function f, Function df, double x_min, double x_max,
+                         double tolerance)
+    : x_min(x_min), x_max(x_max) {
+    // Upper bound of the table size: 2^24 intervals (512 MiB)
+    const std::size_t max_size = std::size_t(1) << 24;
+
+    std::size_t n = 64;
+    tabulate(f, df, n);
+    while (error > tolerance && n < max_size) {
+        n *= 2;
+        tabulate(f, df, n);
+    }
+}
+
+void SplineTable::tabulate(const Function &f, const Function &df,
+                           std::size_t n) {
+    const auto h = (x_max - x_min) / n;
+    inv_h = 1.0 / h;
+    coefficients.resize(n);
+
+    auto f0 = f(x_min);
+    auto d0 = df(x_min) * h;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto f1 = f(x_min + (i + 1) * h);
+        const auto d1 = df(x_min + (i + 1) * h) * h;
+
+        // Hermite basis in t = (x - x_i) / h
+        coefficients[i] = {{f0, d0, 3.0 * (f1 - f0) - 2.0 * d0 - d1,
+                            2.0 * (f0 - f1) + d0 + d1}};
+        f0 = f1;
+        d0 = d1;
+    }
+    error = estimate_error(f);
+}
+
+double SplineTable::estimate_error(const Function &f) const {
+    const auto h = 1.0 / inv_h;
+    auto ret = 0.0;
+    for (std::size_t i = 0; i < coefficients.size(); ++i) {
+        for (auto t : {0.25, 0.5, 0.75}) {
+            const auto x = x_min + (i + t) * h;
+            const auto exact = f(x);
+            const auto diff = std::abs((*this)(x) - exact);
+            ret = std::max(ret, diff / std::max(1.0, std::abs(exact)));
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,71 @@
+#ifndef SPLINETABLE_H_
+#define SPLINETABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * SplineTable
+ *
+ * Piecewise cubic Hermite interpolation of a function on a uniform grid over
+ * [x_min, x_max]. The grid is refined until the interpolation error is below
+ * the requested tolerance, which is absolute for |f| < 1 and relative
+ * otherwise.
+ */
+class SplineTable {
+public:
+    using Function = std::function<double(double)>;
+
+public:
+    /**
+     * Constructor taking the function, its derivative, the tabulated range
+     * and the tolerance of the interpolation.
+     */
+    SplineTable(Function f, Function df, double x_min, double x_max,
+                double tolerance);
+
+    /**
+     * Whether x is inside the tabulated range.
+     */
+    bool contains(double x) const { return x >= x_min && x < x_max; }
+
+    /**
+     * Interpolated value at x, which has to be inside the tabulated range.
+     */
+    double operator()(double x) const {
+        auto t = (x - x_min) * inv_h;
+        const auto i =
+            std::min(static_cast<std::size_t>(t), coefficients.size() - 1);
+        t -= i;
+        const auto &c = coefficients[i];
+        return ((c[3] * t + c[2]) * t + c[1]) * t + c[0];
+    }
+
+    /**
+     * Number of intervals.
+     */
+    std::size_t size() const { return coefficients.size(); }
+
+    /**
+     * Largest interpolation error found while refining the grid.
+     */
+    double max_error() const { return error; }
+
+private:
+    void tabulate(const Function &f, const Function &df, std::size_t n);
+
+    double estimate_error(const Function &f) const;
+
+private:
+    double x_min;
+    double x_max;
+    double inv_h = 0.0;
+    double error = 0.0;
+
+    std::vector<std::array<double, 4>> coefficients;
+};
+
+#endif // SPLINETABLE_H_
@@ -0,0 +1,349 @@
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "BinaryIO.h"
+
+/**
+ * Mean of a time series together with its statistical error and integrated
+ * autocorrelation time (in units of measurements).
+ */
+struct Estimate {
+    double mean;
+    double error;
+    double tau;
+};
+
+/**
+ * BinningAnalysis
+ *
+ * Streaming statistics of a correlated time series. Level k accumulates the
+ * Welford moments of the means of consecutive blocks of 2^k measurements, so
+ * that only O(log n) numbers are kept. The naive error of the mean grows with
+ * the block size until the blocks are longer than the autocorrelation time;
+ * the error is read off the highest level with enough blocks, and the
+ * integrated autocorrelation time follows from
+ *     error_k^2 = (1 + 2 tau) * error_0^2.
+ */
+class BinningAnalysis {
+public:
+    /**
+     * Minimum number of blocks of the level the error is taken from.
+     */
+    static constexpr std::size_t min_blocks = 128;
+
+public:
+    /**
+     * Adds a measurement.
+     */
+    void add(double x) {
+        for (std::size_t k = 0;; ++k) {
+            if (k == levels.size()) {
+                levels.emplace_back();
+            }
+            auto &level = levels[k];
+            ++level.n;
+            const auto delta = x - level.mean;
+            level.mean += delta / static_cast<double>(level.n);
+            level.m2 += delta * (x - level.mean);
+
+            // Combine pairs of blocks into a block of the next level
+            if (!level.pending) {
+                level.pending = true;
+                level.pending_value = x;
+                return;
+            }
+            level.pending = false;
+            x = 0.5 * (level.pending_value + x);
+        }
+    }
+
+    /**
+     * Number of measurements.
+     */
+    std::size_t count() const { return levels.empty() ? 0 : levels[0].n; }
+
+    double mean() const { return levels.empty() ? 0.0 : levels[0].mean; }
+
+    /**
+     * Sample variance of the single measurements.
+     */
+    double variance() const { return levels.empty() ? 0.0 : variance(0); }
+
+    /**
+     * Statistical error of the mean, accounting for autocorrelations.
+     */
+    double error() const {
+        return levels.empty() ? 0.0 : std::sqrt(mean_variance(plateau()));
+    }
+
+    /**
+     * Integrated autocorrelation time in units of measurements. Measurements
+     * about 2 tau apart are effectively independent.
+     */
+    double tau() const {
+        if (levels.empty() || mean_variance(0) <= 0.0) {
+            return 0.0;
+        }
+        return 0.5 * (mean_variance(plateau()) / mean_variance(0) - 1.0);
+    }
+
+    Estimate estimate() const { return Estimate{mean(), error(), tau()}; }
+
+    /**
+     * Adds the measurements of an independent time series, e.g. another
+     * chain at the same beta. Blocks still waiting for their partner are not
+     * carried over to the higher levels.
+     */
+    void merge(const BinningAnalysis &other) {
+        if (levels.size() < other.levels.size()) {
+            levels.resize(other.levels.size());
+        }
+        for (std::size_t k = 0; k < other.levels.size(); ++k) {
+            auto &a = levels[k];
+            const auto &b = other.levels[k];
+            if (b.n == 0) {
+                continue;
+            }
+            const auto n = a.n + b.n;
+            const auto delta = b.mean - a.mean;
+            a.mean += delta * static_cast<double>(b.n) / n;
+            a.m2 += b.m2 + delta * delta * static_cast<double>(a.n) *
+                               static_cast<double>(b.n) / n;
+            a.n = n;
+        }
+    }
+
+    /**
+     * Writes the accumulated moments for a checkpoint.
+     */
+    void save(std::ostream &os) const { write_binary(os, levels); }
+
+    /**
+     * Restores the moments written by save().
+     * returns: false if the stream does not hold them
+     */
+    bool load(std::istream &is) { return read_binary(is, levels); }
+
+private:
+    struct Level {
+        std::size_t n = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        // First block of a pair waiting for its partner
+        bool pending = false;
+        double pending_value = 0.0;
+    };
+
+    double variance(std::size_t k) const {
+        const auto &level = levels[k];
+        return level.n > 1 ? level.m2 / static_cast<double>(level.n - 1) : 0.0;
+    }
+
+    /**
+     * Naive variance of the mean estimated from the blocks of level k.
+     */
+    double mean_variance(std::size_t k) const {
+        return variance(k) / static_cast<double>(levels[k].n);
+    }
+
+    /**
+     * Highest level with at least min_blocks blocks, the lowest otherwise.
+     */
+    std::size_t plateau() const {
+        std::size_t k = 0;
+        while (k + 1 < levels.size() && levels[k + 1].n >= min_blocks) {
+            ++k;
+        }
+        return k;
+    }
+
+private:
+    std::vector<Level> levels;
+};
+
+/**
+ * EquilibrationDetector
+ *
+ * Detects the end of the initial transient of a time series with the
+ * marginal standard error rule (MSER) applied to batch means: the truncation
+ * point d of the n batch means x_i is chosen to minimize
+ *     sum_{i >= d} (x_i - mean_d)^2 / (n - d)^2,
+ * where mean_d is the mean of the batches from d on. The series counts as
+ * equilibrated once the optimal truncation lies in the first half.
+ */
+class EquilibrationDetector {
+public:
+    /**
+     * Constructor taking the number of measurements per batch and the
+     * minimum number of batches before the series can count as equilibrated.
+     */
+    explicit EquilibrationDetector(std::size_t batch_size = 500,
+                                   std::size_t min_batches = 20)
+        : batch_size(batch_size), min_batches(min_batches) {}
+
+    /**
+     * Adds a measurement.
+     */
+    void add(double x) {
+        ++n;
+        batch_sum += x;
+        if (n % batch_size != 0) {
+            return;
+        }
+        batches.push_back(batch_sum / static_cast<double>(batch_size));
+        batch_sum = 0.0;
+        if (batches.size() >= min_batches) {
+            update();
+        }
+    }
+
+    /**
+     * Whether the transient has died out.
+     */
+    bool equilibrated() const { return done; }
+
+    /**
+     * Number of measurements.
+     */
+    std::size_t count() const { return n; }
+
+    /**
+     * Number of measurements belonging to the transient according to the
+     * latest evaluation.
+     */
+    std::size_t truncation() const { return truncated * batch_size; }
+
+    /**
+     * Writes the batches for a checkpoint, the batch size and the minimum
+     * number of batches are part of the construction.
+     */
+    void save(std::ostream &os) const {
+        write_binary(os, n);
+        write_binary(os, batch_sum);
+        write_binary(os, batches);
+        write_binary(os, truncated);
+        write_binary(os, done);
+    }
+
+    /**
+     * Restores the batches written by save().
+     * returns: false if the stream does not hold them
+     */
+    bool load(std::istream &is) {
+        return read_binary(is, n) && read_binary(is, batch_sum) &&
+               read_binary(is, batches) && read_binary(is, truncated) &&
+               read_binary(is, done);
+    }
+
+private:
+    void update() {
+        const auto n_batches = batches.size();
+
+        // Suffix sums of the batch means and their squares; the last few
+        // batches are excluded as truncation points, their statistics are
+        // too poor
+        const std::size_t min_tail = 5;
+        auto sum = 0.0;
+        auto sum_sq = 0.0;
+        auto best = 0.0;
+        for (auto d = n_batches; d-- > 0;) {
+            sum += batches[d];
+            sum_sq += batches[d] * batches[d];
+            const auto m = static_cast<double>(n_batches - d);
+            if (m < min_tail) {
+                continue;
+            }
+            const auto mser = (sum_sq - sum * sum / m) / (m * m);
+            if (d + min_tail == n_batches || mser <= best) {
+                best = mser;
+                truncated = d;
+            }
+        }
+        done = 2 * truncated <= n_batches;
+    }
+
+private:
+    std::size_t batch_size;
+    std::size_t min_batches;
+
+    std::size_t n = 0;
+    double batch_sum = 0.0;
+    std::vector<double> batches;
+
+    std::size_t truncated = 0;
+    bool done = false;
+};
+
+/**
+ * Stage of a Markov chain that is burnt in before it measures, stored in its
+ * checkpoints.
+ */
+enum class ChainStage : std::uint32_t { burn_in, measurement, finished };
+
+/**
+ * Statistics of a Markov chain measuring an observable and the energy after
+ * every step.
+ */
+struct ChainStatistics {
+    BinningAnalysis observable;
+    BinningAnalysis energy;
+    std::size_t accepted = 0;
+    std::size_t steps = 0;
+    std::size_t chains = 1;
+    // Steps discarded as burn-in
+    std::size_t burn_in = 0;
+    // Step size of the proposal, averaged over the chains
+    double delta = 0.0;
+
+    double acceptance() const {
+        return steps > 0 ? static_cast<double>(accepted) / steps : 0.0;
+    }
+
+    /**
+     * Adds the statistics of an independent chain at the same beta.
+     */
+    void merge(const ChainStatistics &other) {
+        delta = (delta * chains + other.delta * other.chains) /
+                (chains + other.chains);
+        observable.merge(other.observable);
+        energy.merge(other.energy);
+        accepted += other.accepted;
+        steps += other.steps;
+        chains += other.chains;
+        burn_in += other.burn_in;
+    }
+
+    /**
+     * Writes the statistics for a checkpoint.
+     */
+    void save(std::ostream &os) const {
+        observable.save(os);
+        energy.save(os);
+        write_binary(os, accepted);
+        write_binary(os, steps);
+        write_binary(os, chains);
+        write_binary(os, burn_in);
+        write_binary(os, delta);
+    }
+
+    /**
+     * Restores the statistics written by save().
+     * returns: false if the stream does not hold them
+     */
+    bool load(std::istream &is) {
+        return observable.load(is) && energy.load(is) &&
+               read_binary(is, accepted) && read_binary(is, steps) &&
+               read_binary(is, chains) && read_binary(is, burn_in) &&
+               read_binary(is, delta);
+    }
+};
+
+#endif // STATISTICS_H_
@@ -0,0 +1,84 @@
+#ifndef STEPSIZETUNER_H_
+#define STEPSIZETUNER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+#include "BinaryIO.h"
+
+/**
+ * StepSizeTuner
+ *
+ * Robbins-Monro adaptation of the step size of a proposal towards a target
+ * acceptance rate. After every window of steps the logarithm of the step
+ * size is moved by (acceptance - target) / k^0.6, where k counts the
+ * windows, so that the adjustments decay and the step size settles.
+ * Adapting the proposal breaks detailed balance, so the tuner may only run
+ * during burn-in and the step size has to be frozen for the measurement.
+ */
+class StepSizeTuner {
+public:
+    /**
+     * Constructor taking the initial and the maximum step size, the target
+     * acceptance rate and the number of steps per window.
+     */
+    StepSizeTuner(double delta, double max_delta, double target = 0.3,
+                  std::size_t window = 100)
+        : log_delta(std::log(delta)), log_max_delta(std::log(max_delta)),
+          target(target), window(window) {}
+
+    /**
+     * Records the outcome of a step. Returns true if the step size changed.
+     */
+    bool add(bool accepted) {
+        if (accepted) {
+            ++accepted_cnt;
+        }
+        if (++steps < window) {
+            return false;
+        }
+        const auto rate = static_cast<double>(accepted_cnt) / window;
+        ++n_windows;
+        log_delta += (rate - target) / std::pow(n_windows, 0.6);
+        log_delta = std::min(log_delta, log_max_delta);
+        steps = 0;
+        accepted_cnt = 0;
+        return true;
+    }
+
+    double get_delta() const { return std::exp(log_delta); }
+
+    /**
+     * Writes the adaptation state for a checkpoint.
+     */
+    void save(std::ostream &os) const {
+        write_binary(os, log_delta);
+        write_binary(os, steps);
+        write_binary(os, accepted_cnt);
+        write_binary(os, n_windows);
+    }
+
+    /**
+     * Restores the adaptation state written by save().
+     * returns: false if the stream does not hold it
+     */
+    bool load(std::istream &is) {
+        return read_binary(is, log_delta) && read_binary(is, steps) &&
+               read_binary(is, accepted_cnt) && read_binary(is, n_windows);
+    }
+
+private:
+    double log_delta;
+    double log_max_delta;
+    double target;
+    std::size_t window;
+
+    std::size_t steps = 0;
+    std::size_t accepted_cnt = 0;
+    std::size_t n_windows = 0;
+};
+
+#endif // STEPSIZETUNER_H_
@@ -0,0 +1,261 @@
+#ifndef SWEEPSCHEDULER_H_
+#define SWEEPSCHEDULER_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+/**
+ * Identifies a single chain of a sweep. index is the position of beta in the
+ * ladder, which together with the repetition gives a unique stream index for
+ * seeding the chain.
+ */
+struct JobKey {
+    double beta;
+    std::size_t repetition;
+    std::size_t index;
+};
+
+/**
+ * SweepScheduler
+ *
+ * Runs the full (beta x repetition) job grid of a sweep on a work-stealing
+ * thread pool and hands the results to a sink in completion order. The sink
+ * is called on the thread calling run(), so it may write to files without
+ * synchronization.
+ */
+template <typename Result>
+class SweepScheduler {
+public:
+    using Job = std::function<Result(const JobKey &)>;
+    using Sink = std::function<void(const JobKey &, const Result &)>;
+
+    /**
+     * Types of a convergence-driven sweep, see run_converging().
+     */
+    using Progress = std::function<bool(const Result &)>;
+    using ConvergingJob =
+        std::function<Result(const JobKey &, const Progress &)>;
+    using Merge = std::function<void(Result &, const Result &)>;
+    using Done = std::function<bool(const Result &)>;
+
+    /**
+     * State of a beta when a convergence-driven sweep was interrupted, used
+     * to resume it: the number of chains that had been started and whether
+     * its result had already been passed to the sink.
+     */
+    struct BetaProgress {
+        std::size_t chains = 0;
+        bool finished = false;
+    };
+
+public:
+    /**
+     * Constructor taking the number of worker threads, defaults to the number
+     * of hardware threads.
+     */
+    explicit SweepScheduler(std::size_t n_threads = ThreadPool::default_size())
+        : pool(n_threads) {}
+
+    /**
+     * Runs job for every combination of beta and repetition and calls sink
+     * for each result as soon as it is available. Returns once all jobs are
+     * finished.
+     */
+    void run(const std::vector<double> &betas, std::size_t repetitions,
+             const Job &job, const Sink &sink) {
+        std::size_t pending = 0;
+        for (std::size_t rep = 0; rep < repetitions; ++rep) {
+            for (std::size_t b = 0; b < betas.size(); ++b) {
+                const JobKey key{betas[b], rep, b};
+                pool.submit([this, key, &job] {
+                    auto result = job(key);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        completed.emplace(key, std::move(result));
+                    }
+                    available.notify_one();
+                });
+                ++pending;
+            }
+        }
+
+        while (pending > 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return !completed.empty(); });
+            auto entry = std::move(completed.front());
+            completed.pop();
+            lock.unlock();
+
+            sink(entry.first, entry.second);
+            --pending;
+        }
+    }
+
+    /**
+     * Convergence-driven sweep. Every beta starts with a single chain, which
+     * job runs in segments, reporting the statistics of its chain so far
+     * through progress after every segment. progress returns false once the
+     * merged statistics of all chains of the beta satisfy done, upon which
+     * job returns its final statistics. Once fewer chains are running than
+     * there are worker threads, every freed thread starts an additional
+     * chain for the unfinished beta with the fewest chains. The merged
+     * result of every beta is passed to sink as soon as all of its chains
+     * have returned.
+     *
+     * Which chains are started depends on the timing of the threads. With
+     * set_max_chains(1) every beta runs a single chain, and a seeded job
+     * gives the same results for every thread count.
+     *
+     * An interrupted sweep is resumed by passing the progress of every beta:
+     * finished betas are skipped, the others restart all of their chains
+     * right away, which job resumes from its own checkpoints.
+     */
+    void run_converging(const std::vector<double> &betas,
+                        const ConvergingJob &job, const Merge &merge,
+                        const Done &done, const Sink &sink,
+                        const std::vector<BetaProgress> &resume = {}) {
+        std::vector<BetaState> states(betas.size());
+        std::queue<std::size_t> returned;
+        std::size_t running = 0;
+
+        // Only called with the mutex locked, merges the chains that have
+        // reported so far, of which there is at least one
+        auto merged = [&](const BetaState &state) {
+            std::size_t first = 0;
+            while (!state.reported[first]) {
+                ++first;
+            }
+            auto ret = state.chains[first];
+            for (std::size_t i = first + 1; i < state.chains.size(); ++i) {
+                if (state.reported[i]) {
+                    merge(ret, state.chains[i]);
+                }
+            }
+            return ret;
+        };
+        auto start = [&](std::size_t b) {
+            auto &state = states[b];
+            const JobKey key{betas[b], state.chains.size(), b};
+            state.chains.emplace_back();
+            state.reported.push_back(0);
+            ++state.running;
+            ++running;
+            pool.submit([&, b, key] {
+                const auto chain = key.repetition;
+                auto result = job(key, [&, b, chain](const Result &partial) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto &state = states[b];
+                    state.chains[chain] = partial;
+                    state.reported[chain] = 1;
+                    if (!state.done) {
+                        state.done = done(merged(state));
+                    }
+                    return !state.done;
+                });
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    states[b].chains[chain] = std::move(result);
+                    states[b].reported[chain] = 1;
+                    returned.push(b);
+                }
+                available.notify_one();
+            });
+        };
+        auto fill = [&] {
+            while (running < pool.size()) {
+                auto best = states.size();
+                for (std::size_t b = 0; b < states.size(); ++b) {
+                    if (!states[b].done && states[b].running > 0 &&
+                        (max_chains == 0 ||
+                         states[b].chains.size() < max_chains) &&
+                        (best == states.size() ||
+                         states[b].running < states[best].running)) {
+                        best = b;
+                    }
+                }
+                if (best == states.size()) {
+                    return;
+                }
+                start(best);
+            }
+        };
+
+        std::unique_lock<std::mutex> lock(mutex);
+        auto pending = betas.size();
+        for (std::size_t b = 0; b < betas.size(); ++b) {
+            if (resume.empty()) {
+                start(b);
+            } else if (resume[b].finished) {
+                states[b].done = true;
+                --pending;
+            } else {
+                const auto chains = std::max<std::size_t>(resume[b].chains, 1);
+                for (std::size_t i = 0; i < chains; ++i) {
+                    start(b);
+                }
+            }
+        }
+        fill();
+
+        while (pending > 0) {
+            available.wait(lock, [&] { return !returned.empty(); });
+            const auto b = returned.front();
+            returned.pop();
+            --running;
+
+            auto &state = states[b];
+            if (--state.running == 0) {
+                state.done = true;
+                const auto result = merged(state);
+                lock.unlock();
+                sink(JobKey{betas[b], 0, b}, result);
+                lock.lock();
+                --pending;
+            }
+            fill();
+        }
+    }
+
+    /**
+     * Limits the number of chains per beta of run_converging(), zero (the
+     * default) means unlimited.
+     */
+    void set_max_chains(std::size_t n) { max_chains = n; }
+
+    /**
+     * Number of worker threads.
+     */
+    std::size_t size() const { return pool.size(); }
+
+private:
+    /**
+     * Chains of a single beta of a convergence-driven sweep.
+     */
+    struct BetaState {
+        // Latest statistics of every chain and whether it has reported any,
+        // started chains hold a default-constructed placeholder until then
+        std::vector<Result> chains;
+        std::vector<char> reported;
+        std::size_t running = 0;
+        bool done = false;
+    };
+
+private:
+    std::size_t max_chains = 0;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::queue<std::pair<JobKey, Result>> completed;
+
+    ThreadPool pool;
+};
+
+#endif // SWEEPSCHEDULER_H_
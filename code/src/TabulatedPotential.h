@@ -0,0 +1,75 @@
+#ifndef TABULATEDPOTENTIAL_H_
+#define TABULATEDPOTENTIAL_H_
+
+#include <cmath>
+#include <memory>
+
+#include "ParticleTraits.h"
+#include "PotentialKernels.h"
+#include "SplineTable.h"
+
+/**
+ * TabulatedCoulombCore
+ *
+ * coulomb_core with both terms read from spline tables over the squared
+ * distance, for cases in which a few ULPs do not matter. Pairs outside of
+ * [r_min, r_max) are evaluated exactly. The tables are shared between copies.
+ */
+class TabulatedCoulombCore {
+public:
+    TabulatedCoulombCore(double r_min, double r_max, double tolerance)
+        : coulomb(std::make_shared<SplineTable>(
+              [](double d2) { return 1.0 / std::sqrt(d2); },
+              [](double d2) { return -0.5 / (d2 * std::sqrt(d2)); },
+              r_min * r_min, r_max * r_max, tolerance)),
+          core(std::make_shared<SplineTable>(
+              [](double d2) { return int_pow<4>(1.0 / d2); },
+              [](double d2) { return -4.0 * int_pow<5>(1.0 / d2); },
+              r_min * r_min, r_max * r_max, tolerance)) {}
+
+    template <typename ParticleState>
+    double operator()(const ParticleState &a, const ParticleState &b) const {
+        const auto d2 = distance_sq(a, b);
+        if (!coulomb->contains(d2)) {
+            return coulomb_core_kernel(d2, a.q * b.q);
+        }
+        return a.q * b.q * (*coulomb)(d2) + (*core)(d2);
+    }
+
+private:
+    std::shared_ptr<const SplineTable> coulomb;
+    std::shared_ptr<const SplineTable> core;
+};
+
+/**
+ * TabulatedLennardJones
+ *
+ * lennard_jones read from a spline table over the squared distance, for cases
+ * in which a few ULPs do not matter. Pairs outside of [r_min, r_max) are
+ * evaluated exactly. The table is shared between copies.
+ */
+class TabulatedLennardJones {
+public:
+    TabulatedLennardJones(double r_min, double r_max, double tolerance)
+        : table(std::make_shared<SplineTable>(
+              [](double d2) { return lennard_jones_kernel(d2); },
+              [](double d2) {
+                  const auto inv_r2 = 1.0 / d2;
+                  return -6.0 * int_pow<7>(inv_r2) + 3.0 * int_pow<4>(inv_r2);
+              },
+              r_min * r_min, r_max * r_max, tolerance)) {}
+
+    template <typename ParticleState>
+    double operator()(const ParticleState &a, const ParticleState &b) const {
+        const auto d2 = distance_sq(a, b);
+        if (!table->contains(d2)) {
+            return lennard_jones_kernel(d2);
+        }
+        return (*table)(d2);
+    }
+
+private:
+    std::shared_ptr<const SplineTable> table;
+};
+
+#endif // TABULATEDPOTENTIAL_H_
@@ -0,0 +1,172 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool
+ *
+ * Work-stealing thread pool. Every worker owns a deque of tasks. Tasks
+ * submitted from outside the pool are distributed round-robin over the
+ * deques, tasks submitted by a worker go to the front of its own deque. A
+ * worker takes tasks from the front of its own deque and, once that is empty,
+ * steals from the back of the others.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor taking the number of worker threads, defaults to the number
+     * of hardware threads.
+     */
+    explicit ThreadPool(std::size_t n_threads = default_size()) {
+        if (n_threads == 0) {
+            n_threads = 1;
+        }
+        for (std::size_t i = 0; i < n_threads; ++i) {
+            queues.emplace_back(new Queue);
+        }
+        for (std::size_t i = 0; i < n_threads; ++i) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Finishes the queued tasks and joins the workers.
+     */
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stop = true;
+        }
+        wake_up.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Queues a task and returns a future to its result.
+     */
+    template <typename Function>
+    auto submit(Function f) -> std::future<decltype(f())> {
+        using Result = decltype(f());
+        auto task =
+            std::make_shared<std::packaged_task<Result()>>(std::move(f));
+        auto ret = task->get_future();
+
+        // Counted before the push, so that a worker popping the task never
+        // sees the counter drop below zero
+        ++queued;
+        const auto own = current_pool() == this;
+        auto &queue = own ? *queues[current_index()]
+                          : *queues[next_queue++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (own) {
+                queue.tasks.emplace_front([task] { (*task)(); });
+            } else {
+                queue.tasks.emplace_back([task] { (*task)(); });
+            }
+        }
+        {
+            // Pairs with the predicate check of sleeping workers
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+        }
+        wake_up.notify_one();
+        return ret;
+    }
+
+    /**
+     * Number of worker threads.
+     */
+    std::size_t size() const { return workers.size(); }
+
+    static std::size_t default_size() {
+        const auto n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static ThreadPool *&current_pool() {
+        thread_local ThreadPool *pool = nullptr;
+        return pool;
+    }
+
+    static std::size_t &current_index() {
+        thread_local std::size_t index = 0;
+        return index;
+    }
+
+    bool pop_front(std::size_t i, std::function<void()> &task) {
+        auto &queue = *queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    bool steal(std::size_t thief, std::function<void()> &task) {
+        for (std::size_t k = 1; k < queues.size(); ++k) {
+            auto &queue = *queues[(thief + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(std::size_t i) {
+        current_pool() = this;
+        current_index() = i;
+
+        while (true) {
+            std::function<void()> task;
+            if (pop_front(i, task) || steal(i, task)) {
+                --queued;
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake_up.wait(lock, [this] { return stop || queued > 0; });
+            if (stop && queued == 0) {
+                return;
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<std::size_t> next_queue{0};
+    std::atomic<std::size_t> queued{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake_up;
+    bool stop = false;
+};
+
+#endif // THREADPOOL_H_
@@ -0,0 +1,54 @@
+#include "Trajectory.h"
+
+#include <cstring>
+#include <istream>
+
+namespace {
+
+const char trajectory_magic[8] = {'P', 'I', 'A', 'P', 'T', 'R', 'J', '\0'};
+const std::uint32_t trajectory_version = 1;
+
+} // namespace
+
+TrajectoryHeader make_trajectory_header(std::size_t dim,
+                                        std::size_t n_particles,
+                                        Precision precision,
+                                        std::size_t stride, double box_length,
+                                        double beta) {
+    TrajectoryHeader ret;
+    std::memcpy(ret.magic, trajectory_magic, sizeof(ret.magic));
+    ret.version = trajectory_version;
+    ret.dim = static_cast<std::uint32_t>(dim);
+    ret.n_particles = n_particles;
+    ret.precision = static_cast<std::uint32_t>(precision);
+    ret.stride = static_cast<std::uint32_t>(stride);
+    ret.box_length = box_length;
+    ret.beta = beta;
+    return ret;
+}
+
+bool valid_trajectory_header(const TrajectoryHeader &header) {
+    return std::memcmp(header.magic, trajectory_magic, 8) == 0 &&
+           header.version == trajectory_version &&
+           (header.precision == 4 || header.precision == 8) &&
+           header.dim >= 1 && header.dim <= 4 && header.n_particles > 0;
+}
+
+bool read_trajectory_header(std::istream &is, TrajectoryHeader &header) {
+    is.read(reinterpret_cast<char *>(&header), sizeof(header));
+    return is && valid_trajectory_header(header);
+}
+
+bool trajectory_fits(const TrajectoryHeader &header, std::size_t file_size) {
+    return file_size >= sizeof(TrajectoryHeader) &&
+           header.n_particles <=
+               (file_size - sizeof(TrajectoryHeader)) / sizeof(double);
+}
+
+std::size_t frame_bytes(const TrajectoryHeader &header) {
+    return header.n_particles * header.dim * header.precision;
+}
+
+std::size_t frames_offset(const TrajectoryHeader &header) {
+    return sizeof(TrajectoryHeader) + header.n_particles * sizeof(double);
+}
@@ -0,0 +1,78 @@
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+/**
+ * Binary trajectory format
+ *
+ *     TrajectoryHeader (48 bytes)
+ *     charges          n_particles x float64
+ *     frames           n_particles x dim x float32/float64 each
+ *
+ * A frame holds the coordinates of all particles, particle after particle.
+ * All values are stored in native byte order. The number of frames follows
+ * from the file size.
+ */
+struct TrajectoryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dim;
+    std::uint64_t n_particles;
+    // Bytes per coordinate: 4 (float32) or 8 (float64)
+    std::uint32_t precision;
+    // Number of Metropolis steps between two frames
+    std::uint32_t stride;
+    double box_length;
+    double beta;
+};
+
+static_assert(sizeof(TrajectoryHeader) == 48, "unexpected header padding");
+
+/**
+ * Precision of the stored coordinates.
+ */
+enum class Precision : std::uint32_t { float32 = 4, float64 = 8 };
+
+/**
+ * Creates a header with magic and version set.
+ */
+TrajectoryHeader make_trajectory_header(std::size_t dim,
+                                        std::size_t n_particles,
+                                        Precision precision,
+                                        std::size_t stride, double box_length,
+                                        double beta);
+
+/**
+ * Checks magic, version, precision, dimension (1 to 4, those of Particle<D>)
+ * and a positive number of particles of a header.
+ */
+bool valid_trajectory_header(const TrajectoryHeader &header);
+
+/**
+ * Reads and validates a header.
+ *
+ * returns: bool - false if the stream does not contain a valid header.
+ */
+bool read_trajectory_header(std::istream &is, TrajectoryHeader &header);
+
+/**
+ * Whether a file of file_size bytes is large enough for the header and the
+ * charges of a valid header. Checked before frames_offset() of a header read
+ * from a file, so that a corrupt number of particles cannot overflow it.
+ */
+bool trajectory_fits(const TrajectoryHeader &header, std::size_t file_size);
+
+/**
+ * Size of a single frame in bytes.
+ */
+std::size_t frame_bytes(const TrajectoryHeader &header);
+
+/**
+ * Offset of the first frame in bytes.
+ */
+std::size_t frames_offset(const TrajectoryHeader &header);
+
+#endif // TRAJECTORY_H_
@@ -0,0 +1,108 @@
+#ifndef TRAJECTORYREADER_H_
+#define TRAJECTORYREADER_H_
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ParticleTraits.h"
+#include "Trajectory.h"
+
+/**
+ * TrajectoryReader
+ *
+ * Reads frames of a binary trajectory file (see Trajectory.h) as states.
+ */
+template <typename ParticleState>
+class TrajectoryReader {
+public:
+    using State = std::vector<ParticleState>;
+    using Traits = ParticleTraits<ParticleState>;
+
+public:
+    /**
+     * Opens a trajectory file. Check good() for success.
+     */
+    explicit TrajectoryReader(const std::string &filename)
+        : is(filename, std::ios::binary) {
+        if (!read_trajectory_header(is, header) ||
+            header.dim != Traits::dim) {
+            return;
+        }
+        is.seekg(0, std::ios::end);
+        const auto file_size = static_cast<std::size_t>(is.tellg());
+        if (!is || !trajectory_fits(header, file_size)) {
+            return;
+        }
+        n_frames = (file_size - frames_offset(header)) / frame_bytes(header);
+
+        charges.resize(header.n_particles);
+        is.seekg(sizeof(header));
+        is.read(reinterpret_cast<char *>(charges.data()),
+                charges.size() * sizeof(double));
+        valid = static_cast<bool>(is);
+    }
+
+    /**
+     * Whether the file contains a valid trajectory of this particle type.
+     */
+    bool good() const { return valid; }
+
+    const TrajectoryHeader &get_header() const { return header; }
+
+    /**
+     * Number of frames.
+     */
+    std::size_t size() const { return n_frames; }
+
+    /**
+     * Reads frame i into state.
+     * returns: false if there is no frame i or it cannot be read
+     */
+    bool read(std::size_t i, State &state) {
+        if (!valid || i >= n_frames) {
+            return false;
+        }
+        buffer.resize(frame_bytes(header));
+        is.clear();
+        is.seekg(frames_offset(header) + i * buffer.size());
+        is.read(buffer.data(), buffer.size());
+        if (!is) {
+            return false;
+        }
+
+        State ret;
+        ret.reserve(header.n_particles);
+        const char *src = buffer.data();
+        double x[Traits::dim];
+        for (std::size_t k = 0; k < header.n_particles; ++k) {
+            for (std::size_t d = 0; d < Traits::dim; ++d) {
+                if (header.precision == 4) {
+                    float value;
+                    std::memcpy(&value, src, sizeof(value));
+                    x[d] = value;
+                } else {
+                    std::memcpy(&x[d], src, sizeof(x[d]));
+                }
+                src += header.precision;
+            }
+            ret.push_back(Traits::make(charges[k], x));
+        }
+        state = std::move(ret);
+        return true;
+    }
+
+private:
+    std::ifstream is;
+    TrajectoryHeader header;
+    bool valid = false;
+    std::size_t n_frames = 0;
+
+    std::vector<double> charges;
+    std::vector<char> buffer;
+};
+
+#endif // TRAJECTORYREADER_H_
@@ -0,0 +1,169 @@
+#ifndef TRAJECTORYWRITER_H_
+#define TRAJECTORYWRITER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ParticleTraits.h"
+#include "Trajectory.h"
+
+/**
+ * TrajectoryWriter
+ *
+ * Streams states into a binary trajectory file (see Trajectory.h) while they
+ * are produced. Frames are encoded into a front buffer; a full buffer is
+ * swapped with the back buffer, which a background thread writes to disk.
+ * Memory use is independent of the number of frames.
+ */
+template <typename ParticleState>
+class TrajectoryWriter {
+public:
+    using State = std::vector<ParticleState>;
+    using Traits = ParticleTraits<ParticleState>;
+
+public:
+    /**
+     * Constructor taking the file name, the initial state (for the number of
+     * particles and their charges), box length, beta, the precision of the
+     * coordinates, the number of states passed to write() per stored frame
+     * and the number of frames per buffer.
+     */
+    TrajectoryWriter(const std::string &filename, const State &initial_state,
+                     double box_length, double beta,
+                     Precision precision = Precision::float64,
+                     std::size_t stride = 1, std::size_t buffer_frames = 1024)
+        : os(filename, std::ios::binary),
+          header(make_trajectory_header(Traits::dim, initial_state.size(),
+                                        precision, stride > 0 ? stride : 1,
+                                        box_length, beta)),
+          stride(stride > 0 ? stride : 1),
+          buffer_size(buffer_frames * frame_bytes(header)) {
+        opened = os.is_open();
+        os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (const auto &p : initial_state) {
+            const double q = p.q;
+            os.write(reinterpret_cast<const char *>(&q), sizeof(q));
+        }
+        front.reserve(buffer_size);
+        back.reserve(buffer_size);
+        writer = std::thread([this] { work(); });
+    }
+
+    TrajectoryWriter(const TrajectoryWriter &) = delete;
+    TrajectoryWriter &operator=(const TrajectoryWriter &) = delete;
+
+    /**
+     * Writes the pending frames and closes the file.
+     */
+    ~TrajectoryWriter() {
+        swap_buffers();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        writer.join();
+    }
+
+    /**
+     * Passes a state to the writer; every stride-th state is stored.
+     */
+    void write(const State &state) {
+        if (count++ % stride != 0) {
+            return;
+        }
+        if (header.precision == 4) {
+            encode<float>(state);
+        } else {
+            encode<double>(state);
+        }
+        ++frames;
+        if (front.size() >= buffer_size) {
+            swap_buffers();
+        }
+    }
+
+    /**
+     * Number of stored frames.
+     */
+    std::size_t size() const { return frames; }
+
+    /**
+     * Whether the file could be opened.
+     */
+    bool is_open() const { return opened; }
+
+private:
+    template <typename Float>
+    void encode(const State &state) {
+        const auto offset = front.size();
+        front.resize(offset + state.size() * Traits::dim * sizeof(Float));
+        auto dst = front.data() + offset;
+        for (const auto &p : state) {
+            for (std::size_t d = 0; d < Traits::dim; ++d) {
+                const auto x = static_cast<Float>(Traits::coordinate(p, d));
+                std::memcpy(dst, &x, sizeof(x));
+                dst += sizeof(x);
+            }
+        }
+    }
+
+    /**
+     * Hands the front buffer to the background thread, waiting for it to
+     * finish the previous one first.
+     */
+    void swap_buffers() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return !back_pending; });
+        front.swap(back);
+        back_pending = true;
+        lock.unlock();
+        condition.notify_all();
+        front.clear();
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            condition.wait(lock, [this] { return back_pending || stop; });
+            if (back_pending) {
+                // The back buffer is owned by this thread until released
+                lock.unlock();
+                os.write(back.data(), back.size());
+                lock.lock();
+                back_pending = false;
+                condition.notify_all();
+            } else if (stop) {
+                os.flush();
+                return;
+            }
+        }
+    }
+
+private:
+    std::ofstream os;
+    TrajectoryHeader header;
+    std::size_t stride;
+    std::size_t buffer_size;
+    bool opened = false;
+
+    std::size_t count = 0;
+    std::size_t frames = 0;
+
+    std::vector<char> front;
+    std::vector<char> back;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool back_pending = false;
+    bool stop = false;
+    std::thread writer;
+};
+
+#endif // TRAJECTORYWRITER_H_
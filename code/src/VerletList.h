@@ -0,0 +1,121 @@
+#ifndef VERLETLIST_H_
+#define VERLETLIST_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "CellList.h"
+#include "ParticleTraits.h"
+
+/**
+ * VerletList
+ *
+ * Neighbour lists of all particles: the partners closer than cutoff + skin
+ * at the time of the last build, stored back to back in one array (CSR
+ * layout) so that visiting the partners of a particle is a linear scan. As
+ * long as every particle stays within skin / 2 of its position at the build,
+ * the list of a particle contains all of its partners within the cutoff. A
+ * move beyond that marks the lists stale, the owner rebuilds them before
+ * their next use.
+ */
+template <typename ParticleState>
+class VerletList {
+public:
+    using size_type = std::size_t;
+
+public:
+    /**
+     * Constructs empty, stale lists.
+     */
+    VerletList() = default;
+
+    /**
+     * Constructor taking the side length of the box, the interaction cutoff,
+     * the skin and whether the box is periodic. The lists are stale until
+     * the first build().
+     */
+    VerletList(double box_length, double cutoff, double skin,
+               bool periodic = false)
+        : box_length(box_length), radius(cutoff + skin), skin(skin),
+          max_shift_sq(0.25 * skin * skin),
+          periodic_length(periodic ? box_length : 0.0) {}
+
+    /**
+     * Collects the partners of all particles from a cell list with the
+     * enlarged radius.
+     */
+    void build(const std::vector<ParticleState> &state) {
+        const CellList<ParticleState> cells(box_length, radius, state,
+                                            periodic_length > 0.0);
+        const auto radius_sq = radius * radius;
+        start.assign(state.size() + 1, 0);
+        index.clear();
+        for (size_type i = 0; i < state.size(); ++i) {
+            cells.for_each_neighbour(state[i], [&](size_type j) {
+                if (j != i && distance_sq(state[i], state[j],
+                                          periodic_length) < radius_sq) {
+                    index.push_back(j);
+                }
+            });
+            start[i + 1] = index.size();
+        }
+        reference = state;
+        stale = false;
+        ++builds;
+    }
+
+    /**
+     * Whether p lies within skin / 2 of the position of particle ix at the
+     * last build, so that the list of ix holds all partners of p.
+     */
+    bool covers(size_type ix, const ParticleState &p) const {
+        return distance_sq(p, reference[ix], periodic_length) <= max_shift_sq;
+    }
+
+    /**
+     * Updates the lists after particle ix moved to new_pos.
+     */
+    void move(size_type ix, const ParticleState &new_pos) {
+        if (!stale && !covers(ix, new_pos)) {
+            stale = true;
+        }
+    }
+
+    bool is_stale() const { return stale; }
+
+    /**
+     * Partners of particle ix: the range [begin, end) of indices.
+     */
+    const size_type *begin(size_type ix) const {
+        return index.data() + start[ix];
+    }
+
+    const size_type *end(size_type ix) const {
+        return index.data() + start[ix + 1];
+    }
+
+    size_type size(size_type ix) const { return start[ix + 1] - start[ix]; }
+
+    double get_skin() const { return skin; }
+
+    /**
+     * Number of builds so far.
+     */
+    std::size_t get_builds() const { return builds; }
+
+private:
+    double box_length = 0.0;
+    double radius = 0.0;
+    double skin = 0.0;
+    double max_shift_sq = 0.0;
+    double periodic_length = 0.0;
+
+    // Partners of particle i are index[start[i]] ... index[start[i + 1] - 1]
+    std::vector<size_type> index;
+    std::vector<size_type> start;
+    std::vector<ParticleState> reference;
+    bool stale = true;
+    std::size_t builds = 0;
+};
+
+#endif // VERLETLIST_H_
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "Common.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+/**
+ * Runs n_steps Metropolis steps and returns the time per step in ns.
+ */
+template <typename Ensemble>
+double time_per_step(Ensemble &ensemble, std::size_t n_steps) {
+    // Warm-up
+    for (std::size_t i = 0; i < n_steps / 10; ++i) {
+        ensemble.step();
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::size_t accepted_cnt = 0;
+    for (std::size_t i = 0; i < n_steps; ++i) {
+        if (ensemble.step()) {
+            ++accepted_cnt;
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    // Keep the loop from being optimized away
+    if (accepted_cnt > n_steps) {
+        std::cout << accepted_cnt;
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           n_steps;
+}
+
+/**
+ * Compares the std::function ensemble against the compile-time policies, whose
+ * energy rows are evaluated by the SIMD kernels at every supported level, and
+ * the batched xoshiro generator against std::mt19937 at the best level.
+ */
+template <typename ParticleState, typename Potential, typename Proposal,
+          typename PotentialPtr>
+void compare(const std::string &name,
+             const std::vector<ParticleState> &init_state, double beta,
+             PotentialPtr potential_ptr, Proposal proposal,
+             std::size_t n_steps) {
+    CanonicalEnsemble<ParticleState> dynamic(init_state, beta, potential_ptr,
+                                             proposal);
+    const auto t_dynamic = time_per_step(dynamic, n_steps);
+    std::cout << name << "\t" << t_dynamic;
+
+    const auto supported = detect_simd_level();
+    for (auto level : {SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512}) {
+        if (static_cast<int>(level) > static_cast<int>(supported)) {
+            std::cout << "\t-";
+            continue;
+        }
+        set_simd_level(level);
+        CanonicalEnsemble<ParticleState, Potential, Proposal> inlined(
+            init_state, beta, Potential(), proposal);
+        std::cout << "\t" << time_per_step(inlined, n_steps);
+    }
+    set_simd_level(supported);
+    CanonicalEnsemble<ParticleState, Potential, Proposal, XoshiroBatch>
+        batched(init_state, beta, Potential(), proposal);
+    std::cout << "\t" << time_per_step(batched, n_steps) << "\n";
+}
+
+/**
+ * Times checkerboard sweeps of a large periodic Lennard-Jones system on 1, 2,
+ * 4, ... threads up to the hardware threads, against single steps, in ns per
+ * attempted step.
+ */
+void checkerboard_scaling(std::size_t n_sweeps) {
+    using Ensemble = CanonicalEnsemble<Particle3D, LennardJones,
+                                       UniformProposal3D, XoshiroBatch>;
+    const double width = 34.0;
+    const auto boundary = Boundary::periodic;
+    Ensemble ensemble(random_state_3d(width, 10000), 1.0,
+                      LennardJones(width),
+                      UniformProposal3D(0.3, width, boundary));
+    ensemble.enable_cell_list(width, 2.5, boundary);
+    ensemble.enable_energy_cache();
+    ensemble.enable_checkerboard();
+    const auto n = ensemble.get_state().size();
+
+    std::cout << "\nthreads\tcheckerboard lennard_jones 3d, " << n
+              << " particles [ns/step]\n";
+    std::cout << "step\t" << time_per_step(ensemble, n_sweeps * n) << "\n";
+    for (std::size_t n_threads = 1;; n_threads *= 2) {
+        n_threads = std::min(n_threads, ThreadPool::default_size());
+        ThreadPool pool(n_threads);
+        // Warm-up
+        for (std::size_t i = 0; i < n_sweeps / 10 + 1; ++i) {
+            ensemble.checkerboard_sweep(pool);
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0; i < n_sweeps; ++i) {
+            ensemble.checkerboard_sweep(pool);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        std::cout << n_threads << "\t"
+                  << std::chrono::duration<double, std::nano>(end - start)
+                             .count() /
+                         (n_sweeps * n)
+                  << "\n";
+        if (n_threads == ThreadPool::default_size()) {
+            break;
+        }
+    }
+}
+
+/**
+ * Times single steps of a dense periodic Lennard-Jones liquid with small
+ * step size on the cell list alone and with Verlet lists of several skins.
+ */
+void neighbour_list_skins(std::size_t n_steps) {
+    using Ensemble = CanonicalEnsemble<Particle3D, LennardJones,
+                                       UniformProposal3D, XoshiroBatch>;
+    const double width = 8.4;
+    const auto boundary = Boundary::periodic;
+    const auto init_state = random_state_3d(width, 250, Seed{1, 0});
+
+    std::cout << "\nskin\tlennard_jones 3d, " << init_state.size()
+              << " particles [ns/step]\tbuilds\n";
+    for (const auto skin : {0.0, 0.2, 0.3, 0.5}) {
+        Ensemble ensemble(init_state, 1.0, LennardJones(width),
+                          UniformProposal3D(0.04, width, boundary),
+                          Seed{1, 0});
+        ensemble.enable_cell_list(width, 2.5, boundary);
+        if (skin > 0.0) {
+            ensemble.enable_neighbour_list(skin);
+        }
+        ensemble.enable_energy_cache();
+        std::cout << skin << "\t" << time_per_step(ensemble, n_steps) << "\t"
+                  << ensemble.get_neighbour_list().get_builds() << "\n";
+    }
+}
+
+int main() {
+    using Potential2D = double (*)(const Particle2D &, const Particle2D &);
+    using Potential3D = double (*)(const Particle3D &, const Particle3D &);
+
+    // Number of oppositely charged particle pairs
+    const unsigned pair_num = 20;
+    // Number of timed steps per configuration
+    const std::size_t n_steps = 500000;
+
+    std::cout << "potential\tstd::function\tscalar\tavx2\tavx512\txoshiro "
+                 "[ns/step]\n";
+
+    compare<Particle2D, CoulombCore>(
+        "coulomb_core 2d", random_state(15.0, pair_num), 100.0,
+        static_cast<Potential2D>(coulomb_core), UniformProposal2D(0.3, 15.0),
+        n_steps);
+    compare<Particle3D, CoulombCore>(
+        "coulomb_core 3d", random_state_3d(8.0, pair_num), 100.0,
+        static_cast<Potential3D>(coulomb_core), UniformProposal3D(0.3, 8.0),
+        n_steps);
+    compare<Particle2D, LennardJones>(
+        "lennard_jones 2d", random_state(12.0, pair_num), 10.0,
+        static_cast<Potential2D>(lennard_jones), UniformProposal2D(0.2, 12.0),
+        n_steps);
+    compare<Particle3D, LennardJones>(
+        "lennard_jones 3d", random_state_3d(5.0, pair_num), 10.0,
+        static_cast<Potential3D>(lennard_jones), UniformProposal3D(0.1, 5.0),
+        n_steps);
+
+    neighbour_list_skins(200000);
+    checkerboard_scaling(20);
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Ewald.h"
+#include "Particle.h"
+
+/**
+ * Madelung constants of the rock-salt lattice and of the square lattice of
+ * alternating charges, referred to the nearest-neighbour distance.
+ */
+const double madelung_3d = 1.747564594633182;
+const double madelung_2d = 1.615542626712310;
+
+/**
+ * Largest tolerated relative error of the Madelung constants.
+ */
+const double madelung_tolerance = 1e-4;
+
+/**
+ * Ions of alternating charge on a lattice with unit spacing and n sites per
+ * axis, n even, filling a periodic box of side length n.
+ */
+template <std::size_t D>
+std::vector<Particle<D>> lattice(std::size_t n) {
+    std::size_t size = 1;
+    for (std::size_t d = 0; d < D; ++d) {
+        size *= n;
+    }
+    std::vector<Particle<D>> ret;
+    for (std::size_t i = 0; i < size; ++i) {
+        std::array<double, D> x;
+        auto rest = i;
+        auto parity = 0;
+        for (std::size_t d = 0; d < D; ++d) {
+            const auto m = rest % n;
+            rest /= n;
+            parity += static_cast<int>(m);
+            x[d] = m + 0.5 - 0.5 * n;
+        }
+        ret.emplace_back(parity % 2 == 0 ? 1.0 : -1.0, x);
+    }
+    return ret;
+}
+
+/**
+ * Random neutral state of n_pairs pairs in a box of side length box_length.
+ */
+template <std::size_t D>
+std::vector<Particle<D>> random_charges(std::size_t n_pairs,
+                                        double box_length) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<> unif(-0.5 * box_length, 0.5 * box_length);
+    std::vector<Particle<D>> ret;
+    for (std::size_t i = 0; i < 2 * n_pairs; ++i) {
+        std::array<double, D> x;
+        for (auto &c : x) {
+            c = unif(rng);
+        }
+        ret.emplace_back(i % 2 == 0 ? 1.0 : -1.0, x);
+    }
+    return ret;
+}
+
+/**
+ * Coulomb energy of the lattice from the screened real-space sum and the
+ * long-range part of the Ewald potential. Prints the Madelung constant
+ * estimated from it, -2 E / N, with its relative error.
+ * returns: whether the error is below madelung_tolerance
+ */
+template <std::size_t D>
+bool check_madelung(std::size_t n, LongRange long_range, double reference) {
+    const auto state = lattice<D>(n);
+    const auto box_length = static_cast<double>(n);
+    const auto cutoff = 0.5 * box_length;
+    EwaldCoulombCore<Particle<D>> potential(box_length, cutoff, 1e-10,
+                                            long_range);
+    potential.long_range_reset(state);
+
+    const auto alpha = potential.get_alpha();
+    auto energy = potential.long_range_energy();
+    for (std::size_t i = 0; i < state.size(); ++i) {
+        for (std::size_t j = i + 1; j < state.size(); ++j) {
+            const auto r = std::sqrt(distance_sq(state[i], state[j],
+                                                 box_length));
+            if (r < cutoff) {
+                energy += state[i].q * state[j].q * std::erfc(alpha * r) / r;
+            }
+        }
+    }
+
+    const auto madelung = -2.0 * energy / state.size();
+    const auto error = std::abs(madelung - reference) / reference;
+    std::cout << D << "d " << (long_range == LongRange::pme ? "pme" : "ewald")
+              << "\t" << madelung << "\t" << reference << "\t" << error
+              << "\n";
+    return error < madelung_tolerance;
+}
+
+/**
+ * Times a full evaluation and single particle trials of both long-range
+ * sums on a random state and prints the relative deviation of the mesh.
+ */
+template <std::size_t D>
+void compare(std::size_t n_pairs, double box_length, double cutoff) {
+    using Potential = EwaldCoulombCore<Particle<D>>;
+    auto state = random_charges<D>(n_pairs, box_length);
+    Potential ewald(box_length, cutoff, 1e-5, LongRange::ewald);
+    Potential pme(box_length, cutoff, 1e-5, LongRange::pme);
+
+    auto reset = [&](Potential &potential) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        potential.long_range_reset(state);
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+    const auto ewald_ms = reset(ewald);
+    const auto pme_ms = reset(pme);
+    const auto energy = ewald.long_range_energy();
+    const auto energy_error =
+        std::abs(pme.long_range_energy() - energy) / std::abs(energy);
+
+    // Random displacements of random particles, every second one accepted
+    const std::size_t n_trials = 200;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::size_t> unif_index(0, state.size() - 1);
+    std::normal_distribution<> normal(0.0, 0.5);
+    std::vector<std::pair<std::size_t, Particle<D>>> moves;
+    for (std::size_t k = 0; k < n_trials; ++k) {
+        const auto ix = unif_index(rng);
+        std::array<double, D> x;
+        for (std::size_t d = 0; d < D; ++d) {
+            x[d] = ParticleTraits<Particle<D>>::coordinate(state[ix], d) +
+                   normal(rng);
+            x[d] -= box_length * std::round(x[d] / box_length);
+        }
+        moves.emplace_back(ix, Particle<D>(state[ix].q, x));
+    }
+    auto trials = [&](Potential &potential, std::vector<double> &deltas) {
+        auto current = state;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (std::size_t k = 0; k < moves.size(); ++k) {
+            const auto ix = moves[k].first;
+            deltas.push_back(
+                potential.long_range_trial(current[ix], moves[k].second));
+            if (k % 2 == 0) {
+                potential.long_range_accept();
+                current[ix] = moves[k].second;
+            }
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start)
+                   .count() /
+               moves.size();
+    };
+    std::vector<double> ewald_deltas;
+    std::vector<double> pme_deltas;
+    const auto ewald_us = trials(ewald, ewald_deltas);
+    const auto pme_us = trials(pme, pme_deltas);
+    auto delta_error = 0.0;
+    for (std::size_t k = 0; k < moves.size(); ++k) {
+        delta_error = std::max(delta_error,
+                               std::abs(pme_deltas[k] - ewald_deltas[k]));
+    }
+
+    std::cout << D << "d\t" << 2 * n_pairs << "\t" << ewald.long_range_size()
+              << "\t" << pme.mesh_size() << "\t" << ewald_ms << "\t"
+              << pme_ms << "\t" << energy_error << "\t" << ewald_us << "\t"
+              << pme_us << "\t" << delta_error << "\n";
+}
+
+int main() {
+    std::cout << "lattice\tmadelung\treference\trelative error\n";
+    auto passed = true;
+    for (const auto long_range : {LongRange::ewald, LongRange::pme}) {
+        passed &= check_madelung<2>(16, long_range, madelung_2d);
+        passed &= check_madelung<3>(8, long_range, madelung_3d);
+    }
+
+    std::cout << "\ndim\tN\tK\tM\tewald ms\tpme ms\trelative error"
+                 "\tewald us/trial\tpme us/trial\tmax trial error\n";
+    for (const std::size_t n_pairs : {100, 1000, 10000}) {
+        // Unit density and a cutoff of 5, at most half the side length
+        const auto box_2d = std::sqrt(2.0 * n_pairs);
+        compare<2>(n_pairs, box_2d, std::min(5.0, 0.5 * box_2d));
+        const auto box_3d = std::cbrt(2.0 * n_pairs);
+        compare<3>(n_pairs, box_3d, std::min(5.0, 0.5 * box_3d));
+    }
+
+    if (!passed) {
+        std::cout << "\nMadelung constants off by more than "
+                  << madelung_tolerance << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Particle.h"
+#include "TabulatedPotential.h"
+
+/**
+ * Previous implementations of the pair potentials based on std::pow, used as
+ * reference for timing and accuracy.
+ */
+double pow_coulomb_core(const Particle3D &a, const Particle3D &b) {
+    const auto distance = std::sqrt(distance_sq(a, b));
+    return a.q * b.q / distance + std::pow(distance, -8.0);
+}
+
+double pow_lennard_jones(const Particle3D &a, const Particle3D &b) {
+    const auto r_sq = distance_sq(a, b);
+    return std::pow(r_sq, -6.0) - std::pow(r_sq, -3.0);
+}
+
+using Pairs = std::vector<std::pair<Particle3D, Particle3D>>;
+
+/**
+ * Random pairs of oppositely charged particles with distances in
+ * [r_min, r_max].
+ */
+Pairs random_pairs(std::size_t n, double r_min, double r_max) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<> unif_r(r_min, r_max);
+    std::normal_distribution<> normal;
+
+    Pairs ret;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto r = unif_r(rng);
+        auto x = normal(rng), y = normal(rng), z = normal(rng);
+        const auto norm = r / std::sqrt(x * x + y * y + z * z);
+        ret.emplace_back(Particle3D(1.0, 0.0, 0.0, 0.0),
+                         Particle3D(-1.0, x * norm, y * norm, z * norm));
+    }
+    return ret;
+}
+
+/**
+ * Prints ns/pair and the largest error relative to the reference (absolute
+ * for |reference| < 1).
+ */
+template <typename Potential, typename Reference>
+void measure(const std::string &name, const Pairs &pairs, Potential potential,
+             Reference reference) {
+    const std::size_t repetitions = 20;
+
+    auto sum = 0.0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t k = 0; k < repetitions; ++k) {
+        for (const auto &pair : pairs) {
+            sum += potential(pair.first, pair.second);
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto ns_per_pair =
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        (repetitions * pairs.size());
+
+    auto error = 0.0;
+    for (const auto &pair : pairs) {
+        const auto exact = reference(pair.first, pair.second);
+        const auto diff = std::abs(potential(pair.first, pair.second) - exact);
+        error = std::max(error, diff / std::max(1.0, std::abs(exact)));
+    }
+
+    std::cout << name << "\t" << ns_per_pair << "\t" << error;
+    // Keep the loop from being optimized away
+    if (std::isnan(sum)) {
+        std::cout << "\tnan";
+    }
+    std::cout << "\n";
+}
+
+std::string table_name(const std::string &potential, double tolerance) {
+    std::ostringstream ss;
+    ss << potential << " table " << tolerance;
+    return ss.str();
+}
+
+int main() {
+    const auto pairs = random_pairs(1000000, 0.8, 10.0);
+
+    using PotentialPtr = double (*)(const Particle3D &, const Particle3D &);
+    const auto coulomb = static_cast<PotentialPtr>(coulomb_core);
+    const auto lj = static_cast<PotentialPtr>(lennard_jones);
+
+    std::cout << "kernel\tns/pair\tmax error\n";
+
+    measure("coulomb_core std::pow", pairs, pow_coulomb_core,
+            pow_coulomb_core);
+    measure("coulomb_core multiply", pairs, coulomb, pow_coulomb_core);
+    for (auto tolerance : {1e-6, 1e-10}) {
+        TabulatedCoulombCore table(0.8, 10.0, tolerance);
+        measure(table_name("coulomb_core", tolerance), pairs,
+                table, pow_coulomb_core);
+    }
+
+    measure("lennard_jones std::pow", pairs, pow_lennard_jones,
+            pow_lennard_jones);
+    measure("lennard_jones multiply", pairs, lj, pow_lennard_jones);
+    for (auto tolerance : {1e-6, 1e-10}) {
+        TabulatedLennardJones table(0.8, 10.0, tolerance);
+        measure(table_name("lennard_jones", tolerance), pairs,
+                table, pow_lennard_jones);
+    }
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "Run.h"
+#include "RunConfig.h"
+
+/**
+ * Parallel tempering of 20 pairs with Coulomb interaction and hard core in a
+ * closed box over the beta ladder of coulomb2d_obs. The options of piap
+ * override the preset.
+ */
+int main(int argc, char *argv[]) {
+    RunConfig config;
+    config.mode = RunMode::tempering;
+    config.potential = PotentialType::coulomb;
+    config.dim = 2;
+    config.pairs = 20;
+    config.box = 15.0;
+    config.boundary = Boundary::hard;
+    config.beta_min = 1.0;
+    config.beta_max = 500.0;
+    config.beta_factor = 1.04;
+    config.delta = 1.0;
+    config.tuning_steps = 20000;
+    config.round_steps = 100;
+    config.burn_in_rounds = 100;
+    config.rounds = 10000;
+    return run_main(argc, argv, "coulomb2d_pt", config);
+}
@@ -0,0 +1,6 @@
+#include "Run.h"
+#include "RunConfig.h"
+
+int main(int argc, char *argv[]) {
+    return run_main(argc, argv, "piap", RunConfig());
+}
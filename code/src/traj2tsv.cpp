@@ -0,0 +1,48 @@
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+
+#include "MappedTrajectory.h"
+
+/**
+ * Writes every frame as a line of q, x, y[, z] per particle, the format read
+ * by the Python scripts.
+ */
+template <typename Float>
+bool convert(const MappedTrajectory &trajectory, std::ostream &os) {
+    const auto charges = trajectory.charges();
+    for (std::size_t i = 0; os && i < trajectory.size(); ++i) {
+        const auto frame = trajectory.frame<Float>(i);
+        for (std::size_t k = 0; k < frame.n_particles; ++k) {
+            os << charges[k] << "\t";
+            for (std::size_t d = 0; d < frame.dim; ++d) {
+                os << frame.coordinate(k, d) << "\t";
+            }
+        }
+        os << "\n";
+    }
+    return static_cast<bool>(os);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: traj2tsv <input.traj> <output.tsv>" << std::endl;
+        return 1;
+    }
+
+    MappedTrajectory trajectory(argv[1]);
+    if (!trajectory.good()) {
+        std::cerr << "Not a trajectory file: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::ofstream os(argv[2]);
+    const auto ok = trajectory.get_header().precision == 4
+                        ? convert<float>(trajectory, os)
+                        : convert<double>(trajectory, os);
+    if (!ok) {
+        std::cerr << "Conversion failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}